@@ -0,0 +1,14 @@
+# arithmetic-heavy loop: linear congruential generator and digit sums
+seed = 12345
+checksum = 0
+i = 0
+while i < 300000:
+    seed = (seed * 1103 + 12345) - (seed * 1103 + 12345) / 65536 * 65536
+    digits = seed
+    while digits > 0:
+        checksum = checksum + digits - digits / 10 * 10
+        digits = digits / 10
+    end
+    i = i + 1
+end
+print checksum
@@ -0,0 +1,46 @@
+#!/bin/sh
+# Startup latency with a cold and a warm --cache-dir: a generated program
+# of many small functions, which does next to nothing once parsed, runs
+# with an empty cache directory and then with the entry in place.
+# usage: cache_latency.sh <pp binary> [functions] [runs]
+
+pp=$1
+functions=${2:-5000}
+runs=${3:-20}
+
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+awk -v n="$functions" 'BEGIN {
+    for (i = 0; i < n; i++) {
+        printf "def f%d(a, b):\n    c = a * %d + b\n    while c > 100:\n        c = c / 2 - 1\n    end\n    return c\nend\n", i, i
+    }
+    print "print f0(1, 2)"
+}' > "$dir/program.pp"
+
+now() {
+    date +%s%N
+}
+
+# prints average milliseconds per run
+measure() {
+    total=0
+    i=0
+    while [ $i -lt $runs ]; do
+        [ "$1" = cold ] && rm -rf "$dir/cache"
+        start=$(now)
+        if [ "$1" = none ]; then
+            "$pp" "$dir/program.pp" > /dev/null || exit 1
+        else
+            "$pp" --cache-dir "$dir/cache" "$dir/program.pp" > /dev/null || exit 1
+        fi
+        total=$((total + $(now) - start))
+        i=$((i + 1))
+    done
+    echo $((total / runs / 1000))
+}
+
+echo "$(wc -l < "$dir/program.pp") lines, $runs runs each"
+echo "no cache:   $(measure none | awk '{ printf "%.2f ms", $1 / 1000 }')"
+echo "cold cache: $(measure cold | awk '{ printf "%.2f ms", $1 / 1000 }')"
+echo "warm cache: $(measure warm | awk '{ printf "%.2f ms", $1 / 1000 }')"
@@ -0,0 +1,39 @@
+#!/bin/sh
+# Differential test of the C backend: every program runs in the interpreter
+# and as an executable built by --compile on the same input, their output,
+# errors and exit codes have to be the same.
+# usage: diff_c.sh <pp binary> <program.pp>...
+
+pp=$1
+shift
+
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+# a count followed by that many numbers, as io.pp reads
+awk 'BEGIN { n = 100000; print n; srand(1); for (i = 0; i < n; i++) print int(rand() * 2000000) - 1000000 }' > "$dir/input"
+
+failed=0
+for program in "$@"; do
+    "$pp" "$program" < "$dir/input" > "$dir/expected" 2>&1
+    echo "exit code $?" >> "$dir/expected"
+
+    if ! "$pp" --compile -o "$dir/program" "$program"; then
+        echo "FAIL $program: can't compile"
+        failed=1
+        continue
+    fi
+
+    "$dir/program" < "$dir/input" > "$dir/actual" 2>&1
+    echo "exit code $?" >> "$dir/actual"
+
+    if cmp -s "$dir/expected" "$dir/actual"; then
+        echo "ok   $program"
+    else
+        echo "FAIL $program"
+        diff "$dir/expected" "$dir/actual" | head -n 10
+        failed=1
+    fi
+done
+
+exit $failed
@@ -0,0 +1,9 @@
+# recursive calls
+def fib(n):
+    if n < 2:
+        return n
+    end
+    return fib(n - 1) + fib(n - 2)
+end
+
+print fib(29)
@@ -0,0 +1,8 @@
+# read/print-heavy: the input is a count followed by that many numbers
+read n
+i = 0
+while i < n:
+    read x
+    print x * 2 - 1
+    i = i + 1
+end
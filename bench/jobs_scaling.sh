@@ -0,0 +1,62 @@
+#!/bin/sh
+# Throughput of pp --jobs from 1 thread to every core, against a process
+# per script: a batch of small generated scripts, each computing and
+# printing a few numbers.
+# usage: jobs_scaling.sh <pp binary> [scripts]
+
+pp=$1
+scripts=${2:-2000}
+
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+i=0
+while [ $i -lt "$scripts" ]; do
+    cat > "$dir/s$i.pp" <<EOF
+def f(n):
+    if n < 2:
+        return n
+    end
+    return f(n - 1) + f(n - 2)
+end
+i = 0
+s = 0
+while i < 1000:
+    s = s + i * $i
+    i = i + 1
+end
+print s
+print f($((12 + i % 5)))
+EOF
+    echo "$dir/s$i.pp" >> "$dir/manifest"
+    i=$((i + 1))
+done
+
+now() {
+    date +%s%N
+}
+
+# prints scripts per second of the command
+measure() {
+    start=$(now)
+    "$@" > /dev/null || exit 1
+    awk -v n="$scripts" -v ns=$(($(now) - start)) 'BEGIN { printf "%.0f scripts/s", n / (ns / 1e9) }'
+}
+
+per_process() {
+    while read -r script; do
+        "$pp" "$script" || return 1
+    done < "$dir/manifest"
+}
+
+cores=$(nproc)
+echo "$scripts scripts, $cores cores"
+echo "process per script: $(measure per_process)"
+
+jobs=1
+while :; do
+    echo "--jobs $jobs: $(measure "$pp" --jobs $jobs --manifest "$dir/manifest")"
+    [ $jobs -ge "$cores" ] && break
+    jobs=$((jobs * 2))
+    [ $jobs -gt "$cores" ] && jobs=$cores
+done
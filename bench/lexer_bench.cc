@@ -0,0 +1,90 @@
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include "lexer.h"
+#include "mapped_lexer.h"
+
+/*
+ * Lexer throughput benchmark: lexes the file with both lexers
+ * several times and reports the best run of each
+ */
+
+typedef std::chrono::steady_clock bench_clock;
+
+size_t lex_all(IScanner & scanner)
+{
+    size_t tokens = 0;
+
+    while (scanner.next_lexeme() != LexemeType::EOFL)
+    {
+        tokens++;
+    }
+
+    return tokens;
+}
+
+void report(std::string const & name, size_t bytes, size_t tokens, double seconds)
+{
+    std::cout << name << ": " 
+              << tokens << " tokens, " 
+              << seconds * 1000 << " ms, "
+              << bytes / seconds / (1 << 20) << " MB/s, "
+              << tokens / seconds / 1e6 << " Mtokens/s" << std::endl;
+}
+
+int main(int argc, char const * argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: lexer_bench <source-file> [repetitions]" << std::endl;
+        return 1;
+    }
+
+    std::string file_name = argv[1];
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    std::ifstream size_stream(file_name, std::ios::binary | std::ios::ate);
+    size_t bytes = size_stream.tellg();
+
+    double best_stream = 0, best_mapped = 0;
+    size_t tokens = 0;
+
+    try
+    {
+        for (int i = 0; i < repetitions; i++)
+        {
+            bench_clock::time_point start = bench_clock::now();
+            std::ifstream src_fstream(file_name, std::ios::in);
+            Lexer lexer(src_fstream);
+            tokens = lex_all(lexer);
+            double elapsed = std::chrono::duration<double>(bench_clock::now() - start).count();
+
+            if (i == 0 || elapsed < best_stream)
+            {
+                best_stream = elapsed;
+            }
+
+            start = bench_clock::now();
+            MappedLexer mapped_lexer(file_name);
+            lex_all(mapped_lexer);
+            elapsed = std::chrono::duration<double>(bench_clock::now() - start).count();
+
+            if (i == 0 || elapsed < best_mapped)
+            {
+                best_mapped = elapsed;
+            }
+        }
+    }
+    catch (LineNumberException &e)
+    {
+        std::cerr << "line number " << e.get_line_number() << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    report("stream lexer", bytes, tokens, best_stream);
+    report("mapped lexer", bytes, tokens, best_mapped);
+
+    return 0;
+}
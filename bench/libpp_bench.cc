@@ -0,0 +1,178 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
+#include "libpp.h"
+
+/*
+ * Throughput of libpp: compiles the script once, then runs the handle
+ * --runs times split over 1, 2, 4, ... --threads threads, every run
+ * with the same input. Runs per second are compared against compiling
+ * the script for every run, and every output has to match the first one
+ */
+
+typedef std::chrono::steady_clock bench_clock;
+
+const size_t output_capacity = 1 << 20;
+
+bool read_file(std::string const & name, std::string & content)
+{
+    std::ifstream stream(name);
+    std::stringstream buffer;
+
+    if (!stream)
+    {
+        return false;
+    }
+
+    buffer << stream.rdbuf();
+    content = buffer.str();
+    return true;
+}
+
+/*
+ * returns the number of runs with an output different from expected
+ */
+size_t run_many(pp::Program const & program, std::string const & input, std::string const & expected,
+                size_t runs, size_t threads_num)
+{
+    std::atomic<size_t> mismatches(0);
+    std::vector<std::thread> threads;
+
+    for (size_t t = 0; t < threads_num; t++)
+    {
+        size_t count = runs / threads_num + (t < runs % threads_num ? 1 : 0);
+
+        threads.emplace_back([&program, &input, &expected, &mismatches, count]()
+        {
+            std::vector<char> output(output_capacity);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                size_t output_size = 0;
+                pp::Result result = program.run(input.data(), input.size(), output.data(), output.size(), output_size);
+
+                if (!result.ok() || std::string(output.data(), output_size) != expected)
+                {
+                    mismatches++;
+                }
+            }
+        });
+    }
+
+    for (std::thread & thread : threads)
+    {
+        thread.join();
+    }
+
+    return mismatches;
+}
+
+double seconds_since(bench_clock::time_point start)
+{
+    return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+int main(int argc, char const * argv[])
+{
+    size_t runs = 10000;
+    size_t max_threads = std::thread::hardware_concurrency();
+    std::string source_file;
+    std::string input_file;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (arg.compare(0, 7, "--runs=") == 0)
+        {
+            runs = std::strtoul(arg.c_str() + 7, nullptr, 10);
+        }
+        else if (arg.compare(0, 10, "--threads=") == 0)
+        {
+            max_threads = std::strtoul(arg.c_str() + 10, nullptr, 10);
+        }
+        else if (source_file.empty())
+        {
+            source_file = arg;
+        }
+        else
+        {
+            input_file = arg;
+        }
+    }
+
+    std::string source;
+    std::string input;
+
+    if (source_file.empty() || runs == 0 || max_threads == 0 || !read_file(source_file, source)
+        || (!input_file.empty() && !read_file(input_file, input)))
+    {
+        std::cerr << "Usage: libpp_bench [--runs=N] [--threads=N] <source-file> [input-file]" << std::endl;
+        return 1;
+    }
+
+    pp::Program program;
+    pp::Result result = pp::Program::compile(source, program);
+
+    if (!result.ok())
+    {
+        std::cerr << "line number " << result.line << ": " << result.message << std::endl;
+        return 1;
+    }
+
+    std::vector<char> output(output_capacity);
+    size_t output_size = 0;
+    result = program.run(input.data(), input.size(), output.data(), output.size(), output_size);
+
+    if (!result.ok())
+    {
+        std::cerr << "line number " << result.line << ": " << result.message << std::endl;
+        return 1;
+    }
+
+    std::string expected(output.data(), output_size);
+
+    //compiling every time is what running a process per script amounts to, minus the process
+    size_t compile_runs = std::max<size_t>(runs / 10, 1);
+    bench_clock::time_point start = bench_clock::now();
+
+    for (size_t i = 0; i < compile_runs; i++)
+    {
+        pp::Program fresh;
+        pp::Program::compile(source, fresh);
+        fresh.run(input.data(), input.size(), output.data(), output.size(), output_size);
+    }
+
+    std::cout << "compile and run, 1 thread: " << compile_runs / seconds_since(start) << " runs/s" << std::endl;
+
+    bool differ = false;
+
+    for (size_t threads = 1; ; threads = std::min(threads * 2, max_threads))
+    {
+        start = bench_clock::now();
+        size_t mismatches = run_many(program, input, expected, runs, threads);
+        double time = seconds_since(start);
+
+        std::cout << "run, " << threads << " threads: " << runs / time << " runs/s";
+        if (mismatches != 0)
+        {
+            std::cout << ", " << mismatches << " outputs differ";
+            differ = true;
+        }
+        std::cout << std::endl;
+
+        if (threads == max_threads)
+        {
+            break;
+        }
+    }
+
+    return differ ? 1 : 0;
+}
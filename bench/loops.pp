@@ -0,0 +1,15 @@
+# nested while loops
+n = 1200
+sum = 0
+i = 0
+while i < n:
+    j = 0
+    while j < n:
+        if j < i:
+            sum = sum + 1
+        end
+        j = j + 1
+    end
+    i = i + 1
+end
+print sum
@@ -0,0 +1,34 @@
+#!/bin/sh
+# Parse time of a large generated library with --parse-jobs from 1 thread
+# to every core: functions with nested blocks and a few top-level statements
+# between them, about 170 bytes a function.
+# usage: parse_scaling.sh <pp binary> [megabytes]
+
+pp=$1
+megabytes=${2:-100}
+
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+awk -v n=$((megabytes * 1024 * 1024 / 170)) 'BEGIN {
+    for (i = 0; i < n; i++) {
+        printf "def f%d(a, b):\n    c = a * %d + b\n    while c > 100:\n        if c > 1000:\n", i, i
+        printf "            c = c / 3\n        end\n        c = c - 7\n    end\n    return c\nend\n"
+        if (i % 100 == 0) {
+            printf "x = f%d(1, 2)\n", i
+        }
+    }
+    print "print x"
+}' > "$dir/library.pp"
+
+echo "$(($(wc -c < "$dir/library.pp") / 1024 / 1024)) MB, $(nproc) cores"
+
+cores=$(nproc)
+jobs=1
+while :; do
+    # parse time of --stats, the sequential one excludes lexing which is timed apart
+    "$pp" --stats --parse-jobs $jobs "$dir/library.pp" 2>&1 > /dev/null | grep -E "^  (lex|parse)"
+    [ $jobs -ge "$cores" ] && break
+    jobs=$((jobs * 2))
+    [ $jobs -gt "$cores" ] && jobs=$cores
+done
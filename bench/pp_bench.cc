@@ -0,0 +1,466 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <functional>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include "lexer.h"
+#include "parser.h"
+#include "optimizer.h"
+#include "resolver.h"
+#include "interpreter.h"
+#include "compiler.h"
+#include "vm.h"
+#include "output.h"
+#include "input.h"
+
+/*
+ * End-to-end benchmark: times lexing, parsing and execution of every
+ * workload separately, writes the results as tab-separated lines
+ *     workload  phase  best-seconds  median-seconds
+ * and compares the best times against a saved baseline.
+ * Parse time excludes lexing, execution time excludes parsing
+ * and covers optimizing, resolving and compiling for the VM.
+ */
+
+typedef std::chrono::steady_clock bench_clock;
+
+struct Workload
+{
+    std::string name;
+    std::string source;
+};
+
+struct Result
+{
+    std::string workload;
+    std::string phase;
+    double best;
+    double median;
+};
+
+struct BenchOptions
+{
+    BenchOptions() : repetitions(7), tolerance(0.2), min_difference(0.005) {}
+
+    int repetitions;
+    //relative slowdown allowed before a phase counts as a regression
+    double tolerance;
+    //differences below it are noise whatever the relative slowdown is
+    double min_difference;
+    std::string baseline_file;
+    std::string output_file;
+    std::vector<std::string> workload_files;
+};
+
+static const size_t generated_functions = 10000;
+static const size_t input_numbers = 500000;
+
+/*
+ * Large source with many small functions, the shape of a generated program
+ */
+std::string generate_large_source(size_t functions)
+{
+    std::ostringstream os;
+
+    for (size_t i = 0; i < functions; i++)
+    {
+        os << "def func_" << i << "(alpha, beta):\n"
+           << "    # helper number " << i << "\n"
+           << "    result_value = alpha * " << i % 97 + 1 << " + beta - " << i % 13 << "\n"
+           << "    while result_value > 1000:\n"
+           << "        result_value = result_value / 2\n"
+           << "    end\n"
+           << "    if result_value == " << i << ":\n"
+           << "        print result_value\n"
+           << "    end\n"
+           << "    return result_value + func_" << (i * 7) % functions << "(beta, alpha - 1)\n"
+           << "end\n\n";
+    }
+
+    os << "total = 0\n"
+       << "i = 0\n"
+       << "while i < 1000:\n"
+       << "    total = total + i\n"
+       << "    i = i + 1\n"
+       << "end\n"
+       << "print total\n";
+
+    return os.str();
+}
+
+/*
+ * Every workload gets the same input: a count followed by that many numbers.
+ * The file is unlinked right away and rewound before each run
+ */
+int create_input(size_t count)
+{
+    char path[] = "/tmp/pp_bench_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    unlink(path);
+
+    std::ostringstream os;
+    os << count << "\n";
+    for (size_t i = 0; i < count; i++)
+    {
+        os << (i * 7919) % 1000003 << "\n";
+    }
+
+    std::string data = os.str();
+    if (write(fd, data.data(), data.size()) != static_cast<ssize_t>(data.size()))
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+size_t lex_all(IScanner & scanner)
+{
+    size_t tokens = 0;
+
+    while (scanner.next_lexeme() != LexemeType::EOFL)
+    {
+        tokens++;
+    }
+
+    return tokens;
+}
+
+ProgramPtr parse(std::string const & source)
+{
+    std::istringstream is(source);
+    Lexer lexer(is);
+    Parser parser(lexer);
+
+    return parser.parse();
+}
+
+double elapsed_since(bench_clock::time_point start)
+{
+    return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+/*
+ * returns seconds spent preparing and running already parsed program
+ */
+double execute(std::string const & source, bool vm, int input_fd, int output_fd)
+{
+    ProgramPtr program = parse(source);
+    lseek(input_fd, 0, SEEK_SET);
+
+    bench_clock::time_point start = bench_clock::now();
+    Optimizer().optimize(program);
+    Resolver().resolve(program);
+
+    OutputBuffer output(output_fd, FlushPolicy::SIZE);
+    InputReader input(input_fd);
+
+    if (vm)
+    {
+        BytecodeProgram bytecode = Compiler().compile(program->get_root());
+        VM(bytecode, output, input).execute();
+    }
+    else
+    {
+        Interpreter(output, input).execute(program->get_root());
+    }
+
+    output.flush();
+    return elapsed_since(start);
+}
+
+/*
+ * runs the phase repeatedly, the phase returns its own time
+ * to leave out the preparation; returns the sorted times
+ */
+std::vector<double> measure(int repetitions, std::function<double()> const & phase)
+{
+    std::vector<double> times;
+
+    for (int i = 0; i < repetitions; i++)
+    {
+        times.push_back(phase());
+    }
+
+    std::sort(times.begin(), times.end());
+    return times;
+}
+
+double median(std::vector<double> const & times)
+{
+    return times[times.size() / 2];
+}
+
+void bench_workload(Workload const & workload, BenchOptions const & options,
+                    int input_fd, int output_fd, std::vector<Result> & results)
+{
+    std::string const & source = workload.source;
+    int repetitions = options.repetitions;
+
+    std::vector<double> lex = measure(repetitions, [&source]() {
+        bench_clock::time_point start = bench_clock::now();
+        std::istringstream is(source);
+        Lexer lexer(is);
+        lex_all(lexer);
+        return elapsed_since(start);
+    });
+
+    //the parser pulls lexemes itself, the best lexing time is subtracted
+    std::vector<double> parse_times = measure(repetitions, [&source]() {
+        bench_clock::time_point start = bench_clock::now();
+        parse(source);
+        return elapsed_since(start);
+    });
+
+    std::vector<double> tree = measure(repetitions, [&source, input_fd, output_fd]() {
+        return execute(source, false, input_fd, output_fd);
+    });
+
+    std::vector<double> vm = measure(repetitions, [&source, input_fd, output_fd]() {
+        return execute(source, true, input_fd, output_fd);
+    });
+
+    double lex_best = lex.front();
+
+    results.push_back({workload.name, "lex", lex_best, median(lex)});
+    results.push_back({workload.name, "parse",
+        std::max(0.0, parse_times.front() - lex_best), std::max(0.0, median(parse_times) - lex_best)});
+    results.push_back({workload.name, "exec_tree", tree.front(), median(tree)});
+    results.push_back({workload.name, "exec_vm", vm.front(), median(vm)});
+}
+
+std::string result_key(std::string const & workload, std::string const & phase)
+{
+    return workload + "\t" + phase;
+}
+
+void print_results(std::ostream & os, std::vector<Result> const & results)
+{
+    for (Result const & result : results)
+    {
+        os << result.workload << "\t" << result.phase << "\t"
+           << result.best << "\t" << result.median << "\n";
+    }
+}
+
+bool write_results(std::string const & file_name, std::vector<Result> const & results)
+{
+    std::ofstream os(file_name);
+    print_results(os, results);
+
+    return static_cast<bool>(os);
+}
+
+/*
+ * returns best times by workload and phase, empty if there is no baseline
+ */
+std::map<std::string, double> read_baseline(std::string const & file_name)
+{
+    std::map<std::string, double> baseline;
+    std::ifstream is(file_name);
+    std::string workload, phase;
+    double best, median;
+
+    while (is >> workload >> phase >> best >> median)
+    {
+        baseline[result_key(workload, phase)] = best;
+    }
+
+    return baseline;
+}
+
+/*
+ * prints the comparison, returns the number of regressions
+ */
+int compare(std::vector<Result> const & results, std::map<std::string, double> const & baseline,
+            BenchOptions const & options)
+{
+    int regressions = 0;
+
+    for (Result const & result : results)
+    {
+        auto it = baseline.find(result_key(result.workload, result.phase));
+        if (it == baseline.end())
+        {
+            continue;
+        }
+
+        double difference = result.best - it->second;
+        bool regression = difference > options.min_difference
+                          && result.best > it->second * (1 + options.tolerance);
+
+        if (regression)
+        {
+            regressions++;
+        }
+
+        std::printf("%-12s %-10s %10.3f ms  baseline %10.3f ms  %+7.1f%%%s\n",
+            result.workload.c_str(), result.phase.c_str(), 1000 * result.best, 1000 * it->second,
+            it->second > 0 ? 100 * difference / it->second : 0.0,
+            regression ? "  REGRESSION" : "");
+    }
+
+    return regressions;
+}
+
+void display_usage()
+{
+    std::cout << "Usage: pp_bench [options] <workload.pp>..." << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --repeat=N          runs of every phase, the best one is compared, 7 by default" << std::endl;
+    std::cout << "  --tolerance=PCT     allowed slowdown against the baseline, 20 by default" << std::endl;
+    std::cout << "  --baseline=FILE     results to compare with, saved there if it doesn't exist" << std::endl;
+    std::cout << "  --output=FILE       where to write the results" << std::endl;
+}
+
+bool parse_options(int argc, char const * argv[], BenchOptions & options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (arg.compare(0, 9, "--repeat=") == 0)
+        {
+            options.repetitions = std::atoi(arg.c_str() + 9);
+        }
+        else if (arg.compare(0, 12, "--tolerance=") == 0)
+        {
+            options.tolerance = std::atof(arg.c_str() + 12) / 100;
+        }
+        else if (arg.compare(0, 11, "--baseline=") == 0)
+        {
+            options.baseline_file = arg.substr(11);
+        }
+        else if (arg.compare(0, 9, "--output=") == 0)
+        {
+            options.output_file = arg.substr(9);
+        }
+        else if (arg.size() > 1 && arg[0] == '-')
+        {
+            std::cerr << "unknown option " << arg << std::endl;
+            return false;
+        }
+        else
+        {
+            options.workload_files.push_back(arg);
+        }
+    }
+
+    return options.repetitions > 0;
+}
+
+std::string workload_name(std::string const & file_name)
+{
+    size_t slash = file_name.find_last_of('/');
+    std::string name = slash == std::string::npos ? file_name : file_name.substr(slash + 1);
+
+    size_t dot = name.rfind(".pp");
+    return dot == std::string::npos ? name : name.substr(0, dot);
+}
+
+int main(int argc, char const * argv[])
+{
+    BenchOptions options;
+
+    if (!parse_options(argc, argv, options))
+    {
+        display_usage();
+        return 1;
+    }
+
+    std::vector<Workload> workloads;
+
+    for (std::string const & file_name : options.workload_files)
+    {
+        std::ifstream is(file_name);
+        if (!is)
+        {
+            std::cerr << "can't open " << file_name << std::endl;
+            return 1;
+        }
+
+        std::ostringstream source;
+        source << is.rdbuf();
+        workloads.push_back({workload_name(file_name), source.str()});
+    }
+
+    workloads.push_back({"generated", generate_large_source(generated_functions)});
+
+    int input_fd = create_input(input_numbers);
+    int output_fd = open("/dev/null", O_WRONLY);
+
+    if (input_fd < 0 || output_fd < 0)
+    {
+        std::cerr << "can't create benchmark input/output" << std::endl;
+        return 1;
+    }
+
+    std::vector<Result> results;
+
+    try
+    {
+        for (Workload const & workload : workloads)
+        {
+            bench_workload(workload, options, input_fd, output_fd, results);
+        }
+    }
+    catch (LineNumberException &e)
+    {
+        std::cerr << "line number " << e.get_line_number() << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    close(input_fd);
+    close(output_fd);
+
+    if (!options.output_file.empty() && !write_results(options.output_file, results))
+    {
+        std::cerr << "can't write " << options.output_file << std::endl;
+        return 1;
+    }
+
+    if (options.baseline_file.empty())
+    {
+        print_results(std::cout, results);
+        return 0;
+    }
+
+    std::map<std::string, double> baseline = read_baseline(options.baseline_file);
+
+    if (baseline.empty())
+    {
+        print_results(std::cout, results);
+
+        if (!write_results(options.baseline_file, results))
+        {
+            std::cerr << "can't write " << options.baseline_file << std::endl;
+            return 1;
+        }
+
+        std::cout << "no baseline yet, saved to " << options.baseline_file << std::endl;
+        return 0;
+    }
+
+    int regressions = compare(results, baseline, options);
+
+    if (regressions > 0)
+    {
+        std::cout << regressions << " regression(s) against " << options.baseline_file << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
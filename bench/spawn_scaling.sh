@@ -0,0 +1,51 @@
+#!/bin/sh
+# Run time of a divide-and-conquer program with --spawn-threads from none,
+# where spawned calls run at sync on the main thread, to one less than the
+# cores: a sum of a pure function over a range, halved by spawns down to
+# ranges of 1000 numbers summed by loops.
+# usage: spawn_scaling.sh <pp binary> [numbers]
+
+pp=$1
+numbers=${2:-20000000}
+
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+cat > "$dir/spawn.pp" <<PP
+def f(i):
+    return i - i / 7 * 7
+end
+def sum(from, to):
+    if to - from <= 1000:
+        s = 0
+        while from < to:
+            s = s + f(from)
+            from = from + 1
+        end
+        return s
+    end
+    middle = (from + to) / 2
+    a = spawn sum(from, middle)
+    b = spawn sum(middle, to)
+    sync
+    return a + b
+end
+print sum(0, $numbers)
+PP
+
+now() {
+    date +%s%N
+}
+
+cores=$(nproc)
+echo "$numbers numbers, $cores cores"
+
+threads=0
+while :; do
+    start=$(now)
+    result=$("$pp" --spawn-threads $threads "$dir/spawn.pp") || exit 1
+    awk -v t=$threads -v r="$result" -v ns=$(($(now) - start)) 'BEGIN { printf "--spawn-threads %d: %.3f s (%s)\n", t, ns / 1e9, r }'
+    [ $threads -ge $((cores - 1)) ] && break
+    threads=$((threads * 2 + 1))
+    [ $threads -gt $((cores - 1)) ] && threads=$((cores - 1))
+done
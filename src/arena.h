@@ -0,0 +1,150 @@
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include "string_ref.h"
+
+#ifndef ARENA_H
+#define ARENA_H
+
+/*
+ * Fixed-size array living in an arena
+ */
+template<class T>
+class ArenaArray
+{
+    public:
+        ArenaArray() : data_(nullptr), size_(0) {}
+        ArenaArray(T * data, uint32_t size) : data_(data), size_(size) {}
+
+        T const * begin() const { return data_; }
+        T const * end() const { return data_ + size_; }
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        T const & operator[](size_t i) const { return data_[i]; }
+        T & operator[](size_t i) { return data_[i]; }
+
+    private:
+        T * data_;
+        uint32_t size_;
+};
+
+/*
+ * Bump allocator, everything allocated is freed at once with the arena.
+ * Destructors are never called so only trivially destructible objects are allowed
+ */
+class Arena
+{
+    public:
+        Arena() : current_(nullptr), left_(0), allocated_(0) {}
+
+        ~Arena()
+        {
+            clear();
+        }
+
+        void * allocate(size_t size, size_t alignment)
+        {
+            size_t padding = -reinterpret_cast<uintptr_t>(current_) & (alignment - 1);
+
+            if (padding + size > left_)
+            {
+                add_block(size + alignment);
+                padding = -reinterpret_cast<uintptr_t>(current_) & (alignment - 1);
+            }
+
+            char * result = current_ + padding;
+            current_ += padding + size;
+            left_ -= padding + size;
+            allocated_ += size;
+
+            return result;
+        }
+
+        template<class T, class... Args>
+        T * make(Args &&... args)
+        {
+            static_assert(std::is_trivially_destructible<T>::value, "arena never calls destructors");
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        template<class T>
+        ArenaArray<T> make_array(std::vector<T> const & items)
+        {
+            static_assert(std::is_trivially_destructible<T>::value, "arena never calls destructors");
+            T * data = static_cast<T *>(allocate(sizeof(T) * items.size(), alignof(T)));
+
+            for (size_t i = 0; i < items.size(); i++)
+            {
+                new (data + i) T(items[i]);
+            }
+
+            return ArenaArray<T>(data, items.size());
+        }
+
+        StringRef make_string(std::string const & value)
+        {
+            char * data = static_cast<char *>(allocate(value.size(), 1));
+            std::memcpy(data, value.data(), value.size());
+
+            return StringRef(data, value.size());
+        }
+
+        /*
+         * frees everything at once, the arena may be used again
+         */
+        void clear()
+        {
+            for (char * block : blocks_)
+            {
+                delete [] block;
+            }
+
+            blocks_.clear();
+            current_ = nullptr;
+            left_ = 0;
+            allocated_ = 0;
+        }
+
+        /*
+         * takes over everything allocated in other, which is left empty
+         */
+        void merge(Arena & other)
+        {
+            blocks_.insert(blocks_.end(), other.blocks_.begin(), other.blocks_.end());
+            allocated_ += other.allocated_;
+
+            other.blocks_.clear();
+            other.current_ = nullptr;
+            other.left_ = 0;
+            other.allocated_ = 0;
+        }
+
+        size_t get_allocated() const { return allocated_; }
+
+        Arena &operator=(Arena const &a) = delete;
+        Arena(Arena const &a) = delete;
+
+    private:
+        static const size_t block_size = 1 << 16;
+
+        void add_block(size_t min_size)
+        {
+            size_t size = min_size > block_size ? min_size : block_size;
+
+            blocks_.push_back(new char[size]);
+            current_ = blocks_.back();
+            left_ = size;
+        }
+
+        std::vector<char *> blocks_;
+        char * current_;
+        size_t left_;
+        size_t allocated_;
+};
+
+#endif //ARENA_H
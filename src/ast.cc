@@ -66,3 +66,37 @@ void BinaryOperatorNode::accept(ASTNodeVisitor * visitor)
     visitor->visit(this);
 }
 
+void VariableLiteralOperatorNode::accept(ASTNodeVisitor * visitor)
+{
+    visitor->visit(this);
+}
+
+void VariablesOperatorNode::accept(ASTNodeVisitor * visitor)
+{
+    visitor->visit(this);
+}
+
+void CompareIfNode::accept(ASTNodeVisitor * visitor)
+{
+    visitor->visit(this);
+}
+
+void CompareWhileNode::accept(ASTNodeVisitor * visitor)
+{
+    visitor->visit(this);
+}
+
+void IncrementNode::accept(ASTNodeVisitor * visitor)
+{
+    visitor->visit(this);
+}
+
+void SpawnNode::accept(ASTNodeVisitor * visitor)
+{
+    visitor->visit(this);
+}
+
+void SyncNode::accept(ASTNodeVisitor * visitor)
+{
+    visitor->visit(this);
+}
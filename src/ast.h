@@ -1,7 +1,10 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <cstdint>
 #include "pp.h"
+#include "arena.h"
+#include "string_ref.h"
 
 
 #ifndef AST_H
@@ -10,8 +13,16 @@
 class ASTNode;
 class ASTNodeVisitor;
 
-typedef std::shared_ptr<ASTNode> ASTNodePtr;
-typedef std::vector<ASTNodePtr> StatementsSequence;
+/*
+ * Nodes are allocated in the arena of their Program and 
+ * are freed all together with it
+ */
+typedef ASTNode * ASTNodePtr;
+typedef ArenaArray<ASTNodePtr> StatementsSequence;
+typedef ArenaArray<StringRef> NamesSequence;
+
+//variable isn't stored in the frame, set by Resolver
+const int no_slot = -1;
 
 class ASTNode {
     public:
@@ -23,7 +34,7 @@ class ASTNode {
 
         virtual void accept(ASTNodeVisitor * visitor) = 0;
     private:
-        size_t line_num_;
+        uint32_t line_num_;
 };
 
 class RootNode : public ASTNode {
@@ -36,65 +47,114 @@ class RootNode : public ASTNode {
 
         StatementsSequence const & get_functions() const { return functions_; }
         StatementsSequence const & get_statements() const { return statements_; }
+        void set_statement(size_t i, ASTNodePtr statement) { statements_[i] = statement; }
+
+        NamesSequence const & get_slot_names() const { return slot_names_; }
+        void set_slot_names(NamesSequence slot_names) { slot_names_ = slot_names; }
        
         virtual void accept(ASTNodeVisitor * visitor) override; 
     private:
         StatementsSequence functions_;
         StatementsSequence statements_;
+        NamesSequence slot_names_;
 };
 
 class FunctionDefinitionNode : public ASTNode {
     public:
-        FunctionDefinitionNode(std::string name, std::vector<std::string> params, StatementsSequence statements) :
+        FunctionDefinitionNode(StringRef name, NamesSequence params, StatementsSequence statements) :
             ASTNode(),
             name_(name),
             params_(params),
-            statements_(statements)
+            statements_(statements),
+            pure_(false),
+            index_(0)
         {}
 
-        std::string const & get_name() const { return name_; }
-        std::vector<std::string> const & get_params() const { return params_; }
+        StringRef get_name() const { return name_; }
+        NamesSequence const & get_params() const { return params_; }
         StatementsSequence const & get_statements() const { return statements_; }
+        void set_statement(size_t i, ASTNodePtr statement) { statements_[i] = statement; }
+
+        NamesSequence const & get_slot_names() const { return slot_names_; }
+        void set_slot_names(NamesSequence slot_names) { slot_names_ = slot_names; }
+
+        /*
+         * result depends on the arguments only, set by PurityAnalyzer
+         */
+        bool is_pure() const { return pure_; }
+        void set_pure(bool pure) { pure_ = pure; }
+
+        /*
+         * position among the definitions of the program, set by Linker
+         */
+        size_t get_index() const { return index_; }
+        void set_index(size_t index) { index_ = index; }
        
         virtual void accept(ASTNodeVisitor * visitor) override; 
     private:
-        std::string name_;
-        std::vector<std::string> params_;
+        StringRef name_;
+        NamesSequence params_;
         StatementsSequence statements_;
+        NamesSequence slot_names_;
+        bool pure_;
+        uint32_t index_;
 };
 
 class AssignmentNode : public ASTNode {
     public:
-        AssignmentNode(std::string var_name, ASTNodePtr expr) :
+        AssignmentNode(StringRef var_name, ASTNodePtr expr) :
             ASTNode(),
             var_name_(var_name),
-            expr_(expr)
+            expr_(expr),
+            slot_(no_slot)
         {}
 
-        std::string const & get_var_name() const { return var_name_; }
+        StringRef get_var_name() const { return var_name_; }
         ASTNodePtr get_expr() const { return expr_; }
+        void set_expr(ASTNodePtr expr) { expr_ = expr; }
+
+        int get_slot() const { return slot_; }
+        void set_slot(int slot) { slot_ = slot; }
        
         virtual void accept(ASTNodeVisitor * visitor) override; 
     private:
-        std::string var_name_;
+        StringRef var_name_;
         ASTNodePtr expr_;
+        int slot_;
 };
 
 class FunctionCallNode : public ASTNode {
     public:
-        FunctionCallNode(std::string name, StatementsSequence params) :
+        FunctionCallNode(StringRef name, StatementsSequence params) :
             ASTNode(),
             name_(name),
-            params_(params)
+            params_(params),
+            is_statement_(false),
+            target_(nullptr)
         {}
 
-        std::string const & get_name() const { return name_; }
+        StringRef get_name() const { return name_; }
         StatementsSequence const & get_params() const { return params_; }
+        void set_param(size_t i, ASTNodePtr param) { params_[i] = param; }
+
+        /*
+         * call of a function for its side effects, a statement on its own
+         */
+        bool is_statement() const { return is_statement_; }
+        void set_statement(bool is_statement) { is_statement_ = is_statement; }
+
+        /*
+         * definition the call is bound to, set by Linker
+         */
+        FunctionDefinitionNode * get_target() const { return target_; }
+        void set_target(FunctionDefinitionNode * target) { target_ = target; }
        
         virtual void accept(ASTNodeVisitor * visitor) override; 
     private:
-        std::string name_;
+        StringRef name_;
         StatementsSequence params_;
+        bool is_statement_;
+        FunctionDefinitionNode * target_;
 };
 
 class IfStatementNode : public ASTNode {
@@ -106,7 +166,9 @@ class IfStatementNode : public ASTNode {
         {}
 
         ASTNodePtr get_expr() const { return expr_; }
+        void set_expr(ASTNodePtr expr) { expr_ = expr; }
         StatementsSequence const & get_statements() const { return statements_; }
+        void set_statement(size_t i, ASTNodePtr statement) { statements_[i] = statement; }
        
         virtual void accept(ASTNodeVisitor * visitor) override; 
     private:
@@ -123,7 +185,9 @@ class WhileStatementNode : public ASTNode {
         {}
 
         ASTNodePtr get_expr() const { return expr_; }
+        void set_expr(ASTNodePtr expr) { expr_ = expr; }
         StatementsSequence const & get_statements() const { return statements_; }
+        void set_statement(size_t i, ASTNodePtr statement) { statements_[i] = statement; }
        
         virtual void accept(ASTNodeVisitor * visitor) override; 
     private:
@@ -133,30 +197,47 @@ class WhileStatementNode : public ASTNode {
 
 class ReadNode : public ASTNode {
     public:
-        ReadNode(std::string var_name) :
+        ReadNode(StringRef var_name) :
             ASTNode(),
-            var_name_(var_name)
+            var_name_(var_name),
+            slot_(no_slot)
         {}
 
-        std::string const & get_var_name() const { return var_name_; }
+        StringRef get_var_name() const { return var_name_; }
+
+        int get_slot() const { return slot_; }
+        void set_slot(int slot) { slot_ = slot; }
        
         virtual void accept(ASTNodeVisitor * visitor) override; 
     private:
-        std::string var_name_;
+        StringRef var_name_;
+        int slot_;
 };
 
 class VariableNode : public ASTNode {
     public:
-        VariableNode(std::string var_name) :
+        VariableNode(StringRef var_name) :
             ASTNode(),
-            var_name_(var_name)
+            var_name_(var_name),
+            slot_(no_slot),
+            global_slot_(no_slot)
         {}
 
-        std::string const & get_var_name() const { return var_name_; }
+        StringRef get_var_name() const { return var_name_; }
+
+        /*
+         * slot in the current frame and slot in the global frame
+         * which is used when local one isn't set
+         */
+        int get_slot() const { return slot_; }
+        int get_global_slot() const { return global_slot_; }
+        void set_slots(int slot, int global_slot) { slot_ = slot; global_slot_ = global_slot; }
        
         virtual void accept(ASTNodeVisitor * visitor) override; 
     private:
-        std::string var_name_;
+        StringRef var_name_;
+        int slot_;
+        int global_slot_;
 };
 
 class LiteralNode : public ASTNode {
@@ -181,6 +262,7 @@ class PrintNode : public ASTNode {
         {}
 
         ASTNodePtr get_expr() const { return expr_; }
+        void set_expr(ASTNodePtr expr) { expr_ = expr; }
        
         virtual void accept(ASTNodeVisitor * visitor) override; 
     private:
@@ -191,14 +273,45 @@ class ReturnNode : public ASTNode {
     public:
         ReturnNode(ASTNodePtr expr) :
             ASTNode(),
-            expr_(expr)
+            expr_(expr),
+            tail_call_(false)
         {}
 
         ASTNodePtr get_expr() const { return expr_; }
+        void set_expr(ASTNodePtr expr) { expr_ = expr; }
+
+        /*
+         * return f(...) within a function, set by Resolver
+         */
+        bool is_tail_call() const { return tail_call_; }
+        void set_tail_call(bool tail_call) { tail_call_ = tail_call; }
        
         virtual void accept(ASTNodeVisitor * visitor) override; 
     private:
         ASTNodePtr expr_;
+        bool tail_call_;
+};
+
+/*
+ * x = spawn f(...), the call may run on another thread and
+ * x gets its result at the next sync of the function
+ */
+class SpawnNode : public AssignmentNode {
+    public:
+        SpawnNode(StringRef var_name, FunctionCallNode * call) :
+            AssignmentNode(var_name, call)
+        {}
+
+        FunctionCallNode * get_call() const { return static_cast<FunctionCallNode *>(get_expr()); }
+       
+        virtual void accept(ASTNodeVisitor * visitor) override; 
+};
+
+class SyncNode : public ASTNode {
+    public:
+        SyncNode() : ASTNode() {}
+       
+        virtual void accept(ASTNodeVisitor * visitor) override; 
 };
 
 class UnaryMinusNode : public ASTNode {
@@ -209,6 +322,7 @@ class UnaryMinusNode : public ASTNode {
         {}
 
         ASTNodePtr get_expr() const { return expr_; }
+        void set_expr(ASTNodePtr expr) { expr_ = expr; }
        
         virtual void accept(ASTNodeVisitor * visitor) override; 
     private:
@@ -232,6 +346,8 @@ class BinaryOperatorNode : public ASTNode {
         BinaryOperatorType get_type() const { return type_; }
         ASTNodePtr get_first_expr() const { return first_expr_; }
         ASTNodePtr get_second_expr() const { return second_expr_; }
+        void set_first_expr(ASTNodePtr expr) { first_expr_ = expr; }
+        void set_second_expr(ASTNodePtr expr) { second_expr_ = expr; }
        
         virtual void accept(ASTNodeVisitor * visitor) override; 
     private:
@@ -240,5 +356,151 @@ class BinaryOperatorNode : public ASTNode {
         ASTNodePtr second_expr_;
 };
 
+/*
+ * Specialized kinds Specializer replaces frequent shapes of resolved programs with.
+ * They keep the operands of the generic node they derive from, and visitors
+ * other than Interpreter see them as that node
+ */
+
+/*
+ * x op literal
+ */
+class VariableLiteralOperatorNode : public BinaryOperatorNode {
+    public:
+        VariableLiteralOperatorNode(BinaryOperatorNode const & node) :
+            BinaryOperatorNode(node),
+            variable_(static_cast<VariableNode *>(node.get_first_expr())),
+            literal_(static_cast<LiteralNode *>(node.get_second_expr())->get_value())
+        {}
+
+        VariableNode * get_variable() const { return variable_; }
+        pp_value_t get_literal() const { return literal_; }
+
+        virtual void accept(ASTNodeVisitor * visitor) override; 
+    private:
+        VariableNode * variable_;
+        pp_value_t literal_;
+};
+
+/*
+ * x op y
+ */
+class VariablesOperatorNode : public BinaryOperatorNode {
+    public:
+        VariablesOperatorNode(BinaryOperatorNode const & node) :
+            BinaryOperatorNode(node),
+            first_variable_(static_cast<VariableNode *>(node.get_first_expr())),
+            second_variable_(static_cast<VariableNode *>(node.get_second_expr()))
+        {}
+
+        VariableNode * get_first_variable() const { return first_variable_; }
+        VariableNode * get_second_variable() const { return second_variable_; }
+
+        virtual void accept(ASTNodeVisitor * visitor) override; 
+    private:
+        VariableNode * first_variable_;
+        VariableNode * second_variable_;
+};
+
+/*
+ * how operands of a comparison are read, in place for the specialized kinds above
+ */
+enum class OperandsKind : short int {
+    ANY, VARIABLE_LITERAL, VARIABLES
+};
+
+inline OperandsKind operands_kind(ASTNodePtr comparison)
+{
+    if (dynamic_cast<VariableLiteralOperatorNode *>(comparison) != nullptr)
+    {
+        return OperandsKind::VARIABLE_LITERAL;
+    }
+
+    if (dynamic_cast<VariablesOperatorNode *>(comparison) != nullptr)
+    {
+        return OperandsKind::VARIABLES;
+    }
+
+    return OperandsKind::ANY;
+}
+
+/*
+ * if on a comparison, which is evaluated along with the branch
+ */
+class CompareIfNode : public IfStatementNode {
+    public:
+        CompareIfNode(IfStatementNode const & node) :
+            IfStatementNode(node),
+            operands_kind_(operands_kind(node.get_expr()))
+        {}
+
+        BinaryOperatorNode * get_condition() const { return static_cast<BinaryOperatorNode *>(get_expr()); }
+        OperandsKind get_operands_kind() const { return operands_kind_; }
+
+        virtual void accept(ASTNodeVisitor * visitor) override; 
+    private:
+        OperandsKind operands_kind_;
+};
+
+/*
+ * while on a comparison
+ */
+class CompareWhileNode : public WhileStatementNode {
+    public:
+        CompareWhileNode(WhileStatementNode const & node) :
+            WhileStatementNode(node),
+            operands_kind_(operands_kind(node.get_expr()))
+        {}
+
+        BinaryOperatorNode * get_condition() const { return static_cast<BinaryOperatorNode *>(get_expr()); }
+        OperandsKind get_operands_kind() const { return operands_kind_; }
+
+        virtual void accept(ASTNodeVisitor * visitor) override; 
+    private:
+        OperandsKind operands_kind_;
+};
+
+/*
+ * x = x + literal, x = literal + x and x = x - literal,
+ * the subtracted literal is kept negated
+ */
+class IncrementNode : public AssignmentNode {
+    public:
+        IncrementNode(AssignmentNode const & node, VariableNode * variable, pp_value_t delta) :
+            AssignmentNode(node),
+            variable_(variable),
+            delta_(delta)
+        {}
+
+        VariableNode * get_variable() const { return variable_; }
+        pp_value_t get_delta() const { return delta_; }
+
+        virtual void accept(ASTNodeVisitor * visitor) override; 
+    private:
+        VariableNode * variable_;
+        pp_value_t delta_;
+};
+
+/*
+ * Parsed program, owns all of its nodes
+ */
+class Program {
+    public:
+        Program() : root_(nullptr) {}
+
+        RootNode * get_root() const { return root_; }
+        void set_root(RootNode * root) { root_ = root; }
+
+        Arena & get_arena() { return arena_; }
+
+        Program &operator=(Program const &a) = delete;
+        Program(Program const &a) = delete;
+    private:
+        Arena arena_;
+        RootNode * root_;
+};
+
+typedef std::shared_ptr<Program> ProgramPtr;
+
 #endif //AST_H
 
@@ -0,0 +1,176 @@
+#include <cstdint>
+#include "ast_printer.h"
+
+static char const * operator_string(BinaryOperatorType type)
+{
+    switch (type)
+    {
+        case BinaryOperatorType::PLUS:           return "+";
+        case BinaryOperatorType::MINUS:          return "-";
+        case BinaryOperatorType::MULTIPLY:       return "*";
+        case BinaryOperatorType::DIVIDE:         return "/";
+        case BinaryOperatorType::EQUALS:         return "==";
+        case BinaryOperatorType::NOT_EQUALS:     return "!=";
+        case BinaryOperatorType::MORE:           return ">";
+        case BinaryOperatorType::MORE_OR_EQUALS: return ">=";
+        case BinaryOperatorType::LESS:           return "<";
+        case BinaryOperatorType::LESS_OR_EQALS:  return "<=";
+    }
+
+    return "?";
+}
+
+void ASTPrinter::print_indent()
+{
+    for (size_t i = 0; i < indent_; i++)
+    {
+        os_ << "    ";
+    }
+}
+
+void ASTPrinter::print_block(StatementsSequence const & statements)
+{
+    indent_++;
+
+    for (ASTNodePtr const & statement : statements)
+    {
+        print_indent();
+        statement->accept(this);
+        os_ << std::endl;
+    }
+
+    indent_--;
+    print_indent();
+    os_ << "end";
+}
+
+void ASTPrinter::visit(RootNode * node)
+{
+    for (ASTNodePtr const & function : node->get_functions())
+    {
+        function->accept(this);
+        os_ << std::endl;
+    }
+
+    for (ASTNodePtr const & statement : node->get_statements())
+    {
+        statement->accept(this);
+        os_ << std::endl;
+    }
+}
+
+void ASTPrinter::visit(FunctionDefinitionNode * node)
+{
+    os_ << "def " << node->get_name().str() << "(";
+
+    for (size_t i = 0; i < node->get_params().size(); i++)
+    {
+        os_ << (i > 0 ? ", " : "") << node->get_params()[i].str();
+    }
+
+    os_ << "):" << std::endl;
+    print_block(node->get_statements());
+}
+
+void ASTPrinter::visit(AssignmentNode * node)
+{
+    os_ << node->get_var_name().str() << " = ";
+    node->get_expr()->accept(this);
+}
+
+void ASTPrinter::visit(FunctionCallNode * node)
+{
+    os_ << node->get_name().str() << "(";
+
+    for (size_t i = 0; i < node->get_params().size(); i++)
+    {
+        os_ << (i > 0 ? ", " : "");
+        node->get_params()[i]->accept(this);
+    }
+
+    os_ << ")";
+}
+
+void ASTPrinter::visit(IfStatementNode * node)
+{
+    os_ << "if ";
+    node->get_expr()->accept(this);
+    os_ << ":" << std::endl;
+    print_block(node->get_statements());
+}
+
+void ASTPrinter::visit(WhileStatementNode * node)
+{
+    os_ << "while ";
+    node->get_expr()->accept(this);
+    os_ << ":" << std::endl;
+    print_block(node->get_statements());
+}
+
+void ASTPrinter::visit(PrintNode * node)
+{
+    os_ << "print ";
+    node->get_expr()->accept(this);
+}
+
+void ASTPrinter::visit(ReadNode * node)
+{
+    os_ << "read " << node->get_var_name().str();
+}
+
+void ASTPrinter::visit(ReturnNode * node)
+{
+    os_ << "return ";
+    node->get_expr()->accept(this);
+}
+
+void ASTPrinter::visit(SpawnNode * node)
+{
+    os_ << node->get_var_name().str() << " = spawn ";
+    node->get_call()->accept(this);
+}
+
+void ASTPrinter::visit(SyncNode *)
+{
+    os_ << "sync";
+}
+
+void ASTPrinter::visit(VariableNode * node)
+{
+    os_ << node->get_var_name().str();
+}
+
+/*
+ * Negative literals appear only after folding and are printed as unary minus
+ */
+void ASTPrinter::visit(LiteralNode * node)
+{
+    if (node->get_value() == INT64_MIN)
+    {
+        os_ << "(-(" << INT64_MAX << ") - 1)";
+    }
+    else if (node->get_value() < 0)
+    {
+        os_ << "-(" << -static_cast<long long>(node->get_value()) << ")";
+    }
+    else
+    {
+        os_ << node->get_value();
+    }
+}
+
+void ASTPrinter::visit(UnaryMinusNode * node)
+{
+    os_ << "-(";
+    node->get_expr()->accept(this);
+    os_ << ")";
+}
+
+void ASTPrinter::visit(BinaryOperatorNode * node)
+{
+    os_ << "(";
+    node->get_first_expr()->accept(this);
+    os_ << " " << operator_string(node->get_type()) << " ";
+    node->get_second_expr()->accept(this);
+    os_ << ")";
+}
@@ -0,0 +1,46 @@
+#include <iostream>
+#include "pp.h"
+#include "ast.h"
+#include "ast_visitor.h"
+
+#ifndef AST_PRINTER_H
+#define AST_PRINTER_H
+
+/*
+ * Prints the tree back as a source program,
+ * every binary operation is parenthesized
+ */
+class ASTPrinter : public ASTNodeVisitor
+{
+    public:
+        explicit
+        ASTPrinter(std::ostream & os) : os_(os), indent_(0) {}
+
+        void print(ASTNodePtr root) { root->accept(this); }
+
+        virtual void visit(RootNode * node) override;
+        virtual void visit(FunctionDefinitionNode * node) override;
+        virtual void visit(AssignmentNode * node) override;
+        virtual void visit(FunctionCallNode * node) override;
+        virtual void visit(IfStatementNode * node) override;
+        virtual void visit(WhileStatementNode * node) override;
+        virtual void visit(PrintNode * node) override;
+        virtual void visit(ReadNode * node) override;
+        virtual void visit(ReturnNode * node) override;
+        virtual void visit(VariableNode * node) override;
+        virtual void visit(LiteralNode * node) override;
+        virtual void visit(UnaryMinusNode * node) override;
+        virtual void visit(BinaryOperatorNode * node) override;
+
+        virtual void visit(SpawnNode * node) override;
+        virtual void visit(SyncNode * node) override;
+
+    private:
+        void print_block(StatementsSequence const & statements);
+        void print_indent();
+
+        std::ostream & os_;
+        size_t indent_;
+};
+
+#endif //AST_PRINTER_H
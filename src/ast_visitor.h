@@ -20,6 +20,21 @@ class ASTNodeVisitor
         virtual void visit(LiteralNode * node) = 0;
         virtual void visit(UnaryMinusNode * node) = 0;
         virtual void visit(BinaryOperatorNode * node) = 0;
+
+        /*
+         * specialized kinds are their generic nodes unless a visitor tells them apart
+         */
+        virtual void visit(VariableLiteralOperatorNode * node) { visit(static_cast<BinaryOperatorNode *>(node)); }
+        virtual void visit(VariablesOperatorNode * node) { visit(static_cast<BinaryOperatorNode *>(node)); }
+        virtual void visit(CompareIfNode * node) { visit(static_cast<IfStatementNode *>(node)); }
+        virtual void visit(CompareWhileNode * node) { visit(static_cast<WhileStatementNode *>(node)); }
+        virtual void visit(IncrementNode * node) { visit(static_cast<AssignmentNode *>(node)); }
+
+        /*
+         * a spawn is an assignment of its call and sync does nothing to visitors not running them
+         */
+        virtual void visit(SpawnNode * node) { visit(static_cast<AssignmentNode *>(node)); }
+        virtual void visit(SyncNode *) {}
 };
 
 #endif //AST_VISITOR_H
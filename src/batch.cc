@@ -0,0 +1,157 @@
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include "batch.h"
+#include "interpreter.h"
+#include "native_stack.h"
+
+/*
+ * returns false if the file can't be read
+ */
+static bool read_file(std::string const & path, std::string & content)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !file.bad();
+}
+
+bool read_manifest(std::string const & path, std::vector<BatchScript> & scripts)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        return false;
+    }
+
+    for (std::string line; std::getline(file, line); )
+    {
+        std::istringstream fields(line);
+        BatchScript script;
+        std::string extra;
+
+        if (!(fields >> script.source_file))
+        {
+            continue;
+        }
+
+        fields >> script.input_file;
+        if (fields >> extra)
+        {
+            return false;
+        }
+
+        scripts.push_back(script);
+    }
+
+    return !file.bad();
+}
+
+void BatchRunner::run_script(BatchScript const & script, Outcome & outcome) const
+{
+    std::string source;
+    std::string input;
+
+    if (!read_file(script.source_file, source))
+    {
+        outcome.error = "can't open " + script.source_file;
+        return;
+    }
+
+    if (!script.input_file.empty() && !read_file(script.input_file, input))
+    {
+        outcome.error = "can't open " + script.input_file;
+        return;
+    }
+
+    pp::Program program;
+    pp::Result result = pp::Program::compile(source, program, compile_options_);
+
+    if (result.ok())
+    {
+        result = program.run(input.data(), input.size(), outcome.output, run_options_);
+    }
+
+    if (!result.ok())
+    {
+        outcome.error = script.source_file + ": line number " + std::to_string(result.line) + ": " + result.message;
+    }
+}
+
+size_t BatchRunner::run(std::vector<BatchScript> const & scripts, std::ostream & out, std::ostream & err) const
+{
+    std::vector<Outcome> outcomes(scripts.size());
+    std::atomic<size_t> next(0);
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    //every user call nests native calls, the stacks are made as deep as max_depth needs
+    size_t stack_size = run_options_.max_depth * Interpreter::native_stack_per_call
+                        + 2 * Interpreter::native_stack_reserve;
+
+    auto work = [this, &scripts, &outcomes, &next, &mutex, &finished]()
+    {
+        for (size_t i = next++; i < scripts.size(); i = next++)
+        {
+            Outcome outcome;
+
+            try
+            {
+                run_script(scripts[i], outcome);
+            }
+            catch (std::exception & e)
+            {
+                outcome.error = scripts[i].source_file + ": " + e.what();
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            outcomes[i] = std::move(outcome);
+            outcomes[i].done = true;
+            finished.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < std::min(jobs_, scripts.size()); i++)
+    {
+        workers.emplace_back([stack_size, &work]() { run_on_native_stack(stack_size, work); });
+    }
+
+    size_t failed = 0;
+
+    for (Outcome & outcome : outcomes)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [&outcome]() { return outcome.done; });
+        }
+
+        out.write(outcome.output.data(), outcome.output.size());
+
+        if (!outcome.error.empty())
+        {
+            out.flush();
+            err << outcome.error << std::endl;
+            failed++;
+        }
+
+        //written ones aren't needed anymore
+        outcome.output = std::string();
+    }
+
+    for (std::thread & worker : workers)
+    {
+        worker.join();
+    }
+
+    out.flush();
+    return failed;
+}
@@ -0,0 +1,61 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "libpp.h"
+
+#ifndef BATCH_H
+#define BATCH_H
+
+/*
+ * Script of a batch and the file its read statements take numbers from,
+ * no input if it's empty
+ */
+struct BatchScript
+{
+    std::string source_file;
+    std::string input_file;
+};
+
+/*
+ * Manifest lines are "<source-file> [input-file]", empty lines are skipped.
+ * Returns false if the file can't be read or a line is malformed
+ */
+bool read_manifest(std::string const & path, std::vector<BatchScript> & scripts);
+
+/*
+ * Runs independent scripts on a pool of threads, each compiled and run on its own.
+ * Output of every script is written as a whole and in the order of the scripts,
+ * its errors follow it prefixed by the name of the script
+ */
+class BatchRunner
+{
+    public:
+        BatchRunner(size_t jobs, pp::CompileOptions const & compile_options, pp::RunOptions const & run_options) :
+            jobs_(jobs),
+            compile_options_(compile_options),
+            run_options_(run_options)
+        {}
+
+        /*
+         * returns the number of scripts that failed
+         */
+        size_t run(std::vector<BatchScript> const & scripts, std::ostream & out, std::ostream & err) const;
+
+    private:
+        struct Outcome
+        {
+            Outcome() : done(false) {}
+
+            bool done;
+            std::string output;
+            std::string error;
+        };
+
+        void run_script(BatchScript const & script, Outcome & outcome) const;
+
+        size_t jobs_;
+        pp::CompileOptions compile_options_;
+        pp::RunOptions run_options_;
+};
+
+#endif //BATCH_H
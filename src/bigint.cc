@@ -0,0 +1,375 @@
+#include <utility>
+#include "bigint.h"
+
+static const uint64_t limb_base = 1ULL << 32;
+//the greatest power of ten a limb holds
+static const uint32_t decimal_chunk = 1000000000;
+static const size_t decimal_chunk_digits = 9;
+
+BigInt::BigInt(pp_value_t value) :
+    negative_(value < 0)
+{
+    uint64_t magnitude = value < 0 ? 0ULL - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+
+    while (magnitude != 0)
+    {
+        limbs_.push_back(static_cast<uint32_t>(magnitude));
+        magnitude >>= 32;
+    }
+}
+
+BigInt::BigInt(bool negative, Limbs && limbs) :
+    negative_(negative),
+    limbs_(std::move(limbs))
+{
+    trim(limbs_);
+    if (limbs_.empty())
+    {
+        negative_ = false;
+    }
+}
+
+BigInt BigInt::from_decimal(bool negative, std::string const & digits)
+{
+    Limbs limbs;
+    size_t first = digits.size() % decimal_chunk_digits;
+    size_t position = 0;
+
+    //limbs = limbs * 10^n + next n digits, n is 9 but for the first chunk
+    for (size_t length = first == 0 ? decimal_chunk_digits : first; position < digits.size(); length = decimal_chunk_digits)
+    {
+        uint64_t multiplier = 1;
+        uint64_t carry = 0;
+
+        for (size_t i = 0; i < length; i++)
+        {
+            multiplier *= 10;
+            carry = carry * 10 + (digits[position++] - '0');
+        }
+
+        for (uint32_t & limb : limbs)
+        {
+            uint64_t product = limb * multiplier + carry;
+            limb = static_cast<uint32_t>(product);
+            carry = product >> 32;
+        }
+
+        if (carry != 0)
+        {
+            limbs.push_back(static_cast<uint32_t>(carry));
+        }
+    }
+
+    return BigInt(negative, std::move(limbs));
+}
+
+bool BigInt::to_small(pp_value_t & value) const
+{
+    if (limbs_.size() > 2)
+    {
+        return false;
+    }
+
+    uint64_t magnitude = 0;
+    for (size_t i = limbs_.size(); i-- > 0; )
+    {
+        magnitude = magnitude << 32 | limbs_[i];
+    }
+
+    uint64_t limit = static_cast<uint64_t>(INT64_MAX) + (negative_ ? 1 : 0);
+    if (magnitude > limit)
+    {
+        return false;
+    }
+
+    value = negative_ ? static_cast<pp_value_t>(0ULL - magnitude) : static_cast<pp_value_t>(magnitude);
+    return true;
+}
+
+/*
+ * Splits off 9 digits at a time by dividing by 10^9
+ */
+std::string BigInt::to_decimal() const
+{
+    if (limbs_.empty())
+    {
+        return "0";
+    }
+
+    Limbs magnitude = limbs_;
+    std::string reversed;
+
+    while (!magnitude.empty())
+    {
+        uint32_t chunk = divide_by_limb(magnitude, decimal_chunk);
+
+        for (size_t i = 0; i < decimal_chunk_digits && (chunk != 0 || !magnitude.empty()); i++)
+        {
+            reversed += static_cast<char>('0' + chunk % 10);
+            chunk /= 10;
+        }
+    }
+
+    if (negative_)
+    {
+        reversed += '-';
+    }
+
+    return std::string(reversed.rbegin(), reversed.rend());
+}
+
+int BigInt::compare(BigInt const & a) const
+{
+    if (negative_ != a.negative_)
+    {
+        return negative_ ? -1 : 1;
+    }
+
+    int result = compare_magnitudes(limbs_, a.limbs_);
+    return negative_ ? -result : result;
+}
+
+uint64_t BigInt::hash() const
+{
+    uint64_t hash = negative_;
+    for (uint32_t limb : limbs_)
+    {
+        hash = (hash ^ limb) * 0x9e3779b97f4a7c15ull;
+        hash ^= hash >> 29;
+    }
+
+    return hash;
+}
+
+BigInt BigInt::operator-() const
+{
+    BigInt result(*this);
+    result.negative_ = !negative_ && !limbs_.empty();
+
+    return result;
+}
+
+BigInt operator+(BigInt const & a, BigInt const & b)
+{
+    return BigInt::add(a, b, false);
+}
+
+BigInt operator-(BigInt const & a, BigInt const & b)
+{
+    return BigInt::add(a, b, true);
+}
+
+BigInt operator*(BigInt const & a, BigInt const & b)
+{
+    return BigInt(a.negative_ != b.negative_, BigInt::multiply_magnitudes(a.limbs_, b.limbs_));
+}
+
+BigInt operator/(BigInt const & a, BigInt const & b)
+{
+    return BigInt(a.negative_ != b.negative_, BigInt::divide_magnitudes(a.limbs_, b.limbs_));
+}
+
+BigInt BigInt::add(BigInt const & a, BigInt const & b, bool negate_b)
+{
+    bool b_negative = b.negative_ != negate_b;
+
+    if (a.negative_ == b_negative)
+    {
+        return BigInt(a.negative_, add_magnitudes(a.limbs_, b.limbs_));
+    }
+
+    //signs differ, the smaller magnitude is taken from the greater one
+    if (compare_magnitudes(a.limbs_, b.limbs_) >= 0)
+    {
+        return BigInt(a.negative_, subtract_magnitudes(a.limbs_, b.limbs_));
+    }
+
+    return BigInt(b_negative, subtract_magnitudes(b.limbs_, a.limbs_));
+}
+
+int BigInt::compare_magnitudes(Limbs const & a, Limbs const & b)
+{
+    if (a.size() != b.size())
+    {
+        return a.size() < b.size() ? -1 : 1;
+    }
+
+    for (size_t i = a.size(); i-- > 0; )
+    {
+        if (a[i] != b[i])
+        {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+
+    return 0;
+}
+
+BigInt::Limbs BigInt::add_magnitudes(Limbs const & a, Limbs const & b)
+{
+    Limbs const & longer = a.size() >= b.size() ? a : b;
+    Limbs const & shorter = a.size() >= b.size() ? b : a;
+    Limbs result(longer.size() + 1);
+    uint64_t carry = 0;
+
+    for (size_t i = 0; i < longer.size(); i++)
+    {
+        uint64_t sum = carry + longer[i] + (i < shorter.size() ? shorter[i] : 0);
+        result[i] = static_cast<uint32_t>(sum);
+        carry = sum >> 32;
+    }
+
+    result[longer.size()] = static_cast<uint32_t>(carry);
+    return result;
+}
+
+BigInt::Limbs BigInt::subtract_magnitudes(Limbs const & a, Limbs const & b)
+{
+    Limbs result(a.size());
+    int64_t borrow = 0;
+
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        int64_t difference = static_cast<int64_t>(a[i]) - (i < b.size() ? b[i] : 0) - borrow;
+        borrow = difference < 0;
+        result[i] = static_cast<uint32_t>(difference + (borrow ? limb_base : 0));
+    }
+
+    return result;
+}
+
+BigInt::Limbs BigInt::multiply_magnitudes(Limbs const & a, Limbs const & b)
+{
+    Limbs result(a.size() + b.size());
+
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        uint64_t carry = 0;
+
+        for (size_t j = 0; j < b.size(); j++)
+        {
+            uint64_t product = static_cast<uint64_t>(a[i]) * b[j] + result[i + j] + carry;
+            result[i + j] = static_cast<uint32_t>(product);
+            carry = product >> 32;
+        }
+
+        result[i + b.size()] = static_cast<uint32_t>(carry);
+    }
+
+    return result;
+}
+
+/*
+ * Returns the remainder, a becomes the quotient
+ */
+uint32_t BigInt::divide_by_limb(Limbs & a, uint32_t b)
+{
+    uint64_t remainder = 0;
+
+    for (size_t i = a.size(); i-- > 0; )
+    {
+        uint64_t dividend = remainder << 32 | a[i];
+        a[i] = static_cast<uint32_t>(dividend / b);
+        remainder = dividend % b;
+    }
+
+    trim(a);
+    return static_cast<uint32_t>(remainder);
+}
+
+/*
+ * Knuth's algorithm D, TAOCP 4.3.1: the divisor is normalized so its top
+ * limb has the high bit set, then every quotient limb is estimated from the
+ * top limbs and corrected at most twice
+ */
+BigInt::Limbs BigInt::divide_magnitudes(Limbs const & a, Limbs const & b)
+{
+    if (compare_magnitudes(a, b) < 0)
+    {
+        return Limbs();
+    }
+
+    if (b.size() == 1)
+    {
+        Limbs quotient = a;
+        divide_by_limb(quotient, b[0]);
+        return quotient;
+    }
+
+    size_t m = a.size();
+    size_t n = b.size();
+    int shift = __builtin_clz(b[n - 1]);
+
+    Limbs v(n);
+    Limbs u(m + 1);
+    for (size_t i = n - 1; i > 0; i--)
+    {
+        v[i] = static_cast<uint32_t>(b[i] << shift | static_cast<uint64_t>(b[i - 1]) >> (32 - shift));
+    }
+    v[0] = b[0] << shift;
+
+    u[m] = static_cast<uint32_t>(static_cast<uint64_t>(a[m - 1]) >> (32 - shift));
+    for (size_t i = m - 1; i > 0; i--)
+    {
+        u[i] = static_cast<uint32_t>(a[i] << shift | static_cast<uint64_t>(a[i - 1]) >> (32 - shift));
+    }
+    u[0] = a[0] << shift;
+
+    Limbs quotient(m - n + 1);
+
+    for (size_t j = m - n + 1; j-- > 0; )
+    {
+        uint64_t dividend = static_cast<uint64_t>(u[j + n]) << 32 | u[j + n - 1];
+        uint64_t estimate = dividend / v[n - 1];
+        uint64_t remainder = dividend % v[n - 1];
+
+        while (estimate >= limb_base || estimate * v[n - 2] > (remainder << 32 | u[j + n - 2]))
+        {
+            estimate--;
+            remainder += v[n - 1];
+            if (remainder >= limb_base)
+            {
+                break;
+            }
+        }
+
+        //u -= estimate * v, shifted by j limbs
+        int64_t borrow = 0;
+        int64_t difference = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            uint64_t product = estimate * v[i];
+            difference = static_cast<int64_t>(u[i + j]) - borrow - static_cast<int64_t>(product & 0xffffffff);
+            u[i + j] = static_cast<uint32_t>(difference);
+            borrow = static_cast<int64_t>(product >> 32) - (difference >> 32);
+        }
+        difference = static_cast<int64_t>(u[j + n]) - borrow;
+        u[j + n] = static_cast<uint32_t>(difference);
+
+        quotient[j] = static_cast<uint32_t>(estimate);
+
+        //the estimate was one too big, v is added back
+        if (difference < 0)
+        {
+            quotient[j]--;
+            uint64_t carry = 0;
+            for (size_t i = 0; i < n; i++)
+            {
+                uint64_t sum = static_cast<uint64_t>(u[i + j]) + v[i] + carry;
+                u[i + j] = static_cast<uint32_t>(sum);
+                carry = sum >> 32;
+            }
+            u[j + n] = static_cast<uint32_t>(u[j + n] + carry);
+        }
+    }
+
+    return quotient;
+}
+
+void BigInt::trim(Limbs & a)
+{
+    while (!a.empty() && a.back() == 0)
+    {
+        a.pop_back();
+    }
+}
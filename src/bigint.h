@@ -0,0 +1,69 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "pp.h"
+
+#ifndef BIGINT_H
+#define BIGINT_H
+
+/*
+ * Arbitrary-precision integer, sign and magnitude. Values take it only once
+ * they don't fit into pp_value_t, so it favours simplicity over speed:
+ * schoolbook multiplication and Knuth's long division
+ */
+class BigInt
+{
+    public:
+        BigInt() : negative_(false) {}
+        explicit BigInt(pp_value_t value);
+
+        /*
+         * digits are decimal ones without a sign, leading zeros are allowed
+         */
+        static BigInt from_decimal(bool negative, std::string const & digits);
+
+        /*
+         * returns false if the number doesn't fit into pp_value_t
+         */
+        bool to_small(pp_value_t & value) const;
+        std::string to_decimal() const;
+
+        bool is_zero() const { return limbs_.empty(); }
+        bool is_negative() const { return negative_; }
+
+        /*
+         * negative, zero or positive as this is less than, equal to or greater than a
+         */
+        int compare(BigInt const & a) const;
+        uint64_t hash() const;
+
+        BigInt operator-() const;
+        friend BigInt operator+(BigInt const & a, BigInt const & b);
+        friend BigInt operator-(BigInt const & a, BigInt const & b);
+        friend BigInt operator*(BigInt const & a, BigInt const & b);
+        //truncates toward zero as C++ does, b mustn't be zero
+        friend BigInt operator/(BigInt const & a, BigInt const & b);
+
+    private:
+        //little-endian, without leading zeros, empty for zero
+        typedef std::vector<uint32_t> Limbs;
+
+        BigInt(bool negative, Limbs && limbs);
+
+        static int compare_magnitudes(Limbs const & a, Limbs const & b);
+        static Limbs add_magnitudes(Limbs const & a, Limbs const & b);
+        //a mustn't be less than b
+        static Limbs subtract_magnitudes(Limbs const & a, Limbs const & b);
+        static Limbs multiply_magnitudes(Limbs const & a, Limbs const & b);
+        static Limbs divide_magnitudes(Limbs const & a, Limbs const & b);
+        static uint32_t divide_by_limb(Limbs & a, uint32_t b);
+        static void trim(Limbs & a);
+
+        //a + b, or a - b with negate_b
+        static BigInt add(BigInt const & a, BigInt const & b, bool negate_b);
+
+        bool negative_;
+        Limbs limbs_;
+};
+
+#endif //BIGINT_H
@@ -0,0 +1,74 @@
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "pp.h"
+
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+/*
+ * Register machine instructions. Every operand is a register index relative
+ * to the current frame base unless stated otherwise:
+ *
+ *   LOADK      a = imm(b)
+ *   LOADC      a = constant b, literals beyond 32 bits
+ *   MOVE       a = b
+ *   GETVAR     a = b, falls back to global c (-1 if none), fails if unset
+ *   GETGLOBAL  a = global b, fails if unset
+ *   DEFINE     marks variable a as set
+ *   NEG        a = -b
+ *   ADD..GE    a = b op c
+ *   ADDK       a = b + imm(c)
+ *   JMP        goto a
+ *   JMPIFNOT   goto b if a <= 0
+ *   JNE..JGE   goto c unless (a op b), fused compare-and-branch
+ *   CALL       a = function b with arguments starting at register c
+ *   TAILCALL   return function b with arguments starting at register c,
+ *              runs it in place of the current frame
+ *   RET        return a
+ *   RET0       return 0
+ *   HALT       stop the program
+ *   PRINT      print a
+ *   READ       read a value into a
+ *   FAIL       raise runtime error with message a
+ */
+enum class OpCode : unsigned char
+{
+    LOADK, LOADC, MOVE, GETVAR, GETGLOBAL, DEFINE,
+    NEG, ADD, SUB, MUL, DIV,
+    EQ, NE, LT, LE, GT, GE,
+    ADDK,
+    JMP, JMPIFNOT,
+    JEQ, JNE, JLT, JLE, JGT, JGE,
+    CALL, TAILCALL, RET, RET0, HALT,
+    PRINT, READ, FAIL
+};
+
+struct Instruction
+{
+    OpCode op;
+    int32_t a;
+    int32_t b;
+    int32_t c;
+};
+
+struct FunctionCode
+{
+    std::string name;
+    size_t params_num;
+    size_t variables_num;
+    size_t frame_size;
+    std::vector<std::string> slot_names;
+    std::vector<Instruction> code;
+    std::vector<size_t> lines;
+};
+
+struct BytecodeProgram
+{
+    FunctionCode main;
+    std::vector<FunctionCode> functions;
+    std::vector<std::string> messages;
+    std::vector<pp_value_t> constants;
+};
+
+#endif //BYTECODE_H
@@ -0,0 +1,746 @@
+#include <cstdint>
+#include "c_emitter.h"
+#include "interpreter.h"
+#include "input.h"
+
+static char const c_prologue[] = R"(#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#if defined(__GNUC__)
+#define PP_NOINLINE __attribute__((noinline))
+#else
+#define PP_NOINLINE
+#endif
+
+typedef int64_t pp_value_t;
+)";
+
+/*
+ * Runtime of the generated program: buffered output flushed per line
+ * on terminals, input parsed as InputReader does, errors and call depth checks.
+ * There are no big values, arithmetic that overflows and numbers in input
+ * beyond pp_value_t are errors. Limits and messages are defined before it
+ */
+static char const c_runtime[] = R"(
+static size_t pp_depth;
+static uintptr_t pp_stack_limit;
+
+static char pp_out[1 << 20];
+static size_t pp_out_size;
+static int pp_line_flush;
+
+static char pp_in[1 << 20];
+static size_t pp_in_position;
+static size_t pp_in_size;
+static int pp_in_eof;
+
+static void pp_flush(void)
+{
+    size_t written = 0;
+
+    while (written < pp_out_size)
+    {
+        ssize_t result = write(1, pp_out + written, pp_out_size - written);
+
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+
+        written += result;
+    }
+
+    pp_out_size = 0;
+}
+
+static void pp_fail(int line, char const * msg)
+{
+    pp_flush();
+    fprintf(stderr, "line number %d: %s\n", line, msg);
+    exit(1);
+}
+
+static pp_value_t pp_add(pp_value_t a, pp_value_t b, int line)
+{
+    pp_value_t result;
+    if (__builtin_add_overflow(a, b, &result))
+    {
+        pp_fail(line, pp_overflow);
+    }
+    return result;
+}
+
+static pp_value_t pp_sub(pp_value_t a, pp_value_t b, int line)
+{
+    pp_value_t result;
+    if (__builtin_sub_overflow(a, b, &result))
+    {
+        pp_fail(line, pp_overflow);
+    }
+    return result;
+}
+
+static pp_value_t pp_mul(pp_value_t a, pp_value_t b, int line)
+{
+    pp_value_t result;
+    if (__builtin_mul_overflow(a, b, &result))
+    {
+        pp_fail(line, pp_overflow);
+    }
+    return result;
+}
+
+static pp_value_t pp_neg(pp_value_t a, int line)
+{
+    if (a == INT64_MIN)
+    {
+        pp_fail(line, pp_overflow);
+    }
+    return -a;
+}
+
+static void pp_print(pp_value_t value)
+{
+    char digits[24];
+    char * p = digits + sizeof(digits);
+    unsigned long long abs_value = value < 0 ? 0ULL - value : (unsigned long long) value;
+
+    if (sizeof(pp_out) - pp_out_size < 24)
+    {
+        pp_flush();
+    }
+
+    do
+    {
+        *--p = (char) ('0' + abs_value % 10);
+        abs_value /= 10;
+    }
+    while (abs_value > 0);
+
+    if (value < 0)
+    {
+        *--p = '-';
+    }
+
+    memcpy(pp_out + pp_out_size, p, digits + sizeof(digits) - p);
+    pp_out_size += digits + sizeof(digits) - p;
+    pp_out[pp_out_size++] = '\n';
+
+    if (pp_line_flush)
+    {
+        pp_flush();
+    }
+}
+
+static int pp_peek(void)
+{
+    while (pp_in_position == pp_in_size)
+    {
+        ssize_t result;
+
+        if (pp_in_eof)
+        {
+            return -1;
+        }
+
+        result = read(0, pp_in, sizeof(pp_in));
+        pp_in_position = 0;
+        pp_in_size = 0;
+
+        if (result > 0)
+        {
+            pp_in_size = result;
+        }
+        else if (result == 0 || errno != EINTR)
+        {
+            pp_in_eof = 1;
+        }
+    }
+
+    return (unsigned char) pp_in[pp_in_position];
+}
+
+static pp_value_t pp_read(int line)
+{
+    pp_value_t result = 0;
+    int negative = 0;
+    int overflow = 0;
+    int c = pp_peek();
+
+    while (c != -1 && isspace(c))
+    {
+        pp_in_position++;
+        c = pp_peek();
+    }
+
+    if (c == -1)
+    {
+        pp_fail(line, pp_end_of_input);
+    }
+
+    if (c == '-' || c == '+')
+    {
+        negative = c == '-';
+        pp_in_position++;
+        c = pp_peek();
+    }
+
+    if (c == -1 || !isdigit(c))
+    {
+        pp_fail(line, pp_invalid_number);
+    }
+
+    while (c != -1 && isdigit(c))
+    {
+        if (__builtin_mul_overflow(result, 10, &result) || __builtin_sub_overflow(result, c - '0', &result))
+        {
+            overflow = 1;
+            result = INT64_MIN;
+        }
+
+        pp_in_position++;
+        c = pp_peek();
+    }
+
+    if (c != -1 && !isspace(c))
+    {
+        pp_fail(line, pp_invalid_number);
+    }
+
+    if (overflow || (!negative && result == INT64_MIN))
+    {
+        pp_fail(line, pp_out_of_range);
+    }
+
+    return negative ? result : -result;
+}
+
+/* made before the arguments are evaluated, the frame of this function stands for the callee's one */
+static PP_NOINLINE void pp_check_call(int line)
+{
+    char marker;
+
+    if (pp_depth >= PP_MAX_DEPTH || (uintptr_t) &marker < pp_stack_limit)
+    {
+        pp_fail(line, "maximum call depth exceeded");
+    }
+}
+
+static void pp_main(void);
+
+static void * pp_run(void * stack_size)
+{
+    char marker;
+
+    pp_stack_limit = (uintptr_t) &marker - *(size_t *) stack_size + PP_STACK_RESERVE;
+    pp_main();
+
+    return NULL;
+}
+
+int main(void)
+{
+    /* every call nests C calls, so the program runs on a stack as deep as PP_MAX_DEPTH needs */
+    size_t stack_size = (size_t) PP_MAX_DEPTH * PP_STACK_PER_CALL + 2 * PP_STACK_RESERVE;
+    pthread_attr_t attr;
+    pthread_t thread;
+
+    pp_line_flush = isatty(1);
+
+    if (pthread_attr_init(&attr) == 0 && pthread_attr_setstacksize(&attr, stack_size) == 0
+        && pthread_create(&thread, &attr, pp_run, &stack_size) == 0)
+    {
+        pthread_join(thread, NULL);
+    }
+    else
+    {
+        pp_main();
+    }
+
+    pp_flush();
+    return 0;
+}
+)";
+
+
+static std::string c_string(std::string const & text)
+{
+    std::string result = "\"";
+
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            result += '\\';
+        }
+        result += c;
+    }
+
+    return result + "\"";
+}
+
+template<class T>
+static T * node_cast(ASTNodePtr const & node)
+{
+    return dynamic_cast<T *>(&*node);
+}
+
+void CEmitter::emit(ASTNodePtr root, std::string const & source_name)
+{
+    os_ << "/* generated by pp from " << source_name << " */" << std::endl;
+    os_ << c_prologue << std::endl;
+
+    os_ << "#define PP_MAX_DEPTH " << max_depth_ << std::endl;
+    os_ << "#define PP_STACK_PER_CALL " << Interpreter::native_stack_per_call << std::endl;
+    os_ << "#define PP_STACK_RESERVE " << Interpreter::native_stack_reserve << std::endl << std::endl;
+
+    os_ << "static char const pp_end_of_input[] = "
+        << c_string(InputReader::error_message(ReadResult::END_OF_INPUT)) << ";" << std::endl;
+    os_ << "static char const pp_invalid_number[] = "
+        << c_string(InputReader::error_message(ReadResult::INVALID_NUMBER)) << ";" << std::endl;
+    os_ << "static char const pp_out_of_range[] = \"number in input is out of range\";" << std::endl;
+    os_ << "static char const pp_overflow[] = \"integer overflow\";" << std::endl;
+
+    os_ << c_runtime;
+    root->accept(this);
+}
+
+void CEmitter::visit(RootNode * node)
+{
+    root_ = node;
+
+    VariablesAnalyzer main_analyzer;
+    main_analyzer.analyze(node->get_statements(), NamesSequence());
+    checked_globals_ = main_analyzer.get_checked_names();
+
+    std::map<FunctionDefinitionNode *, VariablesAnalyzer> analyzers;
+    for (ASTNodePtr const & function : node->get_functions())
+    {
+        FunctionDefinitionNode * definition = node_cast<FunctionDefinitionNode>(function);
+        functions_[definition->get_name().str()] = definition;
+    }
+
+    //functions read globals that may be not set yet
+    for (auto const & function : functions_)
+    {
+        VariablesAnalyzer & analyzer = analyzers[function.second];
+        analyzer.analyze(function.second->get_statements(), function.second->get_params());
+        checked_globals_.insert(analyzer.get_checked_names().begin(), analyzer.get_checked_names().end());
+    }
+
+    os_ << std::endl;
+    for (StringRef name : node->get_slot_names())
+    {
+        os_ << "static pp_value_t g_" << name.str() << ";" << std::endl;
+        if (is_checked_global(name))
+        {
+            os_ << "static char gd_" << name.str() << ";" << std::endl;
+        }
+    }
+
+    os_ << std::endl;
+    for (auto const & function : functions_)
+    {
+        std::string params;
+        for (StringRef param : function.second->get_params())
+        {
+            params += (params.empty() ? "" : ", ") + ("pp_value_t v_" + param);
+        }
+
+        os_ << "static pp_value_t f_" << function.first << "(" << (params.empty() ? "void" : params) << ");" << std::endl;
+    }
+
+    is_main_ = false;
+    for (auto const & function : functions_)
+    {
+        analyzer_ = &analyzers[function.second];
+        emit_function(function.second);
+    }
+
+    is_main_ = true;
+    function_ = nullptr;
+    analyzer_ = &main_analyzer;
+    next_temp_ = 0;
+    indent_ = 0;
+    body_.str("");
+
+    emit_block(node->get_statements());
+    os_ << std::endl << "static void pp_main(void)" << std::endl << body_.str();
+}
+
+void CEmitter::visit(FunctionDefinitionNode *)
+{
+    //functions are emitted from RootNode
+}
+
+void CEmitter::emit_function(FunctionDefinitionNode * node)
+{
+    function_ = node;
+    next_temp_ = 0;
+    body_.str("");
+
+    std::string params;
+    for (StringRef param : node->get_params())
+    {
+        params += (params.empty() ? "" : ", ") + ("pp_value_t v_" + param);
+    }
+
+    os_ << std::endl << "static pp_value_t f_" << node->get_name().str() << "(" << (params.empty() ? "void" : params) << ")"
+        << std::endl << "{" << std::endl;
+
+    NamesSequence const & slot_names = node->get_slot_names();
+    for (size_t slot = node->get_params().size(); slot < slot_names.size(); slot++)
+    {
+        os_ << "    pp_value_t v_" << slot_names[slot].str() << " = 0;" << std::endl;
+    }
+
+    for (std::string const & name : analyzer_->get_checked_names())
+    {
+        bool is_local = false;
+        for (StringRef slot_name : slot_names)
+        {
+            is_local = is_local || slot_name.str() == name;
+        }
+
+        //parameters are always set
+        if (is_local)
+        {
+            os_ << "    char d_" << name << " = 0;" << std::endl;
+        }
+    }
+
+    indent_ = 1;
+    emit_sequence(node->get_statements());
+    emit_line("return 0;");
+
+    os_ << body_.str() << "}" << std::endl;
+}
+
+void CEmitter::emit_sequence(StatementsSequence const & statements)
+{
+    for (ASTNodePtr const & statement : statements)
+    {
+        statement->accept(this);
+    }
+}
+
+void CEmitter::emit_block(StatementsSequence const & statements)
+{
+    emit_line("{");
+    indent_++;
+    emit_sequence(statements);
+    indent_--;
+    emit_line("}");
+}
+
+void CEmitter::emit_line(std::string const & code)
+{
+    body_ << std::string(4 * indent_, ' ') << code << "\n";
+}
+
+void CEmitter::emit_fail(std::string const & msg, ASTNode const * node)
+{
+    emit_line("pp_fail(" + std::to_string(node->get_line_num()) + ", " + c_string(msg) + ");");
+}
+
+std::string CEmitter::new_temp()
+{
+    return "t" + std::to_string(next_temp_++);
+}
+
+std::string CEmitter::local_name(int slot) const
+{
+    if (is_main_)
+    {
+        return global_name(slot);
+    }
+
+    return "v_" + function_->get_slot_names()[slot];
+}
+
+std::string CEmitter::global_name(int slot) const
+{
+    return "g_" + root_->get_slot_names()[slot];
+}
+
+std::string CEmitter::literal(pp_value_t value)
+{
+    if (value == INT64_MIN)
+    {
+        return "INT64_MIN";
+    }
+
+    return value < 0 ? "(" + std::to_string(value) + ")" : std::to_string(value);
+}
+
+void CEmitter::visit(AssignmentNode * node)
+{
+    std::string value = emit_operand(node->get_expr());
+    int slot = node->get_slot();
+
+    emit_line(local_name(slot) + " = " + value + ";");
+
+    StringRef name = node->get_var_name();
+    if (is_main_ ? is_checked_global(name) : analyzer_->get_checked_names().count(name.str()) != 0)
+    {
+        emit_line(std::string(is_main_ ? "gd_" : "d_") + name + " = 1;");
+    }
+}
+
+/*
+ * Lookup errors come first, then the depth check
+ * and then the arguments, as the interpreter does
+ */
+std::string CEmitter::emit_call(FunctionCallNode * node, bool check_depth)
+{
+    std::string line = std::to_string(node->get_line_num());
+    auto function = functions_.find(node->get_name().str());
+
+    if (function == functions_.end())
+    {
+        emit_fail("undefined function " + node->get_name(), node);
+        return "";
+    }
+
+    if (function->second->get_params().size() != node->get_params().size())
+    {
+        emit_fail("arguments number mismatch for " + node->get_name(), node);
+        return "";
+    }
+
+    if (check_depth)
+    {
+        emit_line("pp_check_call(" + line + ");");
+    }
+
+    std::string args;
+    for (ASTNodePtr const & param : node->get_params())
+    {
+        std::string arg = emit_operand(param);
+        args += (args.empty() ? "" : ", ") + arg;
+    }
+
+    return "f_" + function->first + "(" + args + ")";
+}
+
+void CEmitter::visit(FunctionCallNode * node)
+{
+    std::string call = emit_call(node, true);
+
+    if (call.empty())
+    {
+        result_ = "0";
+        return;
+    }
+
+    emit_line("pp_depth++;");
+
+    if (node->is_statement())
+    {
+        emit_line(call + ";");
+        result_ = "0";
+    }
+    else
+    {
+        result_ = new_temp();
+        emit_line("pp_value_t " + result_ + " = " + call + ";");
+    }
+
+    emit_line("pp_depth--;");
+}
+
+void CEmitter::visit(IfStatementNode * node)
+{
+    std::string condition = emit_operand(node->get_expr());
+
+    emit_line("if (" + condition + " > 0)");
+    emit_block(node->get_statements());
+}
+
+void CEmitter::visit(WhileStatementNode * node)
+{
+    emit_line("for (;;)");
+    emit_line("{");
+    indent_++;
+
+    std::string condition = emit_operand(node->get_expr());
+    emit_line("if (" + condition + " <= 0)");
+    emit_line("    break;");
+    emit_sequence(node->get_statements());
+
+    indent_--;
+    emit_line("}");
+}
+
+void CEmitter::visit(PrintNode * node)
+{
+    emit_line("pp_print(" + emit_operand(node->get_expr()) + ");");
+}
+
+void CEmitter::visit(ReadNode * node)
+{
+    emit_line(local_name(node->get_slot()) + " = pp_read(" + std::to_string(node->get_line_num()) + ");");
+
+    StringRef name = node->get_var_name();
+    if (is_main_ ? is_checked_global(name) : analyzer_->get_checked_names().count(name.str()) != 0)
+    {
+        emit_line(std::string(is_main_ ? "gd_" : "d_") + name + " = 1;");
+    }
+}
+
+void CEmitter::visit(SpawnNode * node)
+{
+    throw CompilerException(node->get_line_num(), "spawn is supported by the tree engine only");
+}
+
+void CEmitter::visit(SyncNode * node)
+{
+    throw CompilerException(node->get_line_num(), "sync is supported by the tree engine only");
+}
+
+void CEmitter::visit(ReturnNode * node)
+{
+    if (!is_main_ && node->is_tail_call())
+    {
+        //the callee takes over the depth of the returning function
+        std::string call = emit_call(static_cast<FunctionCallNode *>(node->get_expr()), false);
+        if (!call.empty())
+        {
+            emit_line("return " + call + ";");
+        }
+        return;
+    }
+
+    std::string value = emit_operand(node->get_expr());
+    emit_line(is_main_ ? "return;" : "return " + value + ";");
+}
+
+void CEmitter::visit(VariableNode * node)
+{
+    int local = node->get_slot();
+    int global = node->get_global_slot();
+    StringRef name = node->get_var_name();
+
+    result_ = new_temp();
+
+    if (local >= 0 && !analyzer_->is_checked_read(node))
+    {
+        emit_line("pp_value_t " + result_ + " = " + local_name(local) + ";");
+        return;
+    }
+
+    emit_line("pp_value_t " + result_ + ";");
+
+    std::string fail = "pp_fail(" + std::to_string(node->get_line_num()) + ", "
+                       + c_string("undefined variable " + name) + ");";
+
+    if (local >= 0)
+    {
+        emit_line(std::string("if (") + (is_main_ ? "gd_" : "d_") + name + ")");
+        emit_line("    " + result_ + " = " + local_name(local) + ";");
+        if (global >= 0)
+        {
+            emit_line("else if (gd_" + name + ")");
+            emit_line("    " + result_ + " = " + global_name(global) + ";");
+        }
+        emit_line("else");
+        emit_line("    " + fail);
+    }
+    else if (global >= 0)
+    {
+        emit_line("if (gd_" + name + ")");
+        emit_line("    " + result_ + " = " + global_name(global) + ";");
+        emit_line("else");
+        emit_line("    " + fail);
+    }
+    else
+    {
+        emit_line(fail);
+    }
+}
+
+void CEmitter::visit(LiteralNode * node)
+{
+    result_ = literal(node->get_value());
+}
+
+void CEmitter::visit(UnaryMinusNode * node)
+{
+    std::string value = emit_operand(node->get_expr());
+
+    result_ = new_temp();
+    emit_line("pp_value_t " + result_ + " = pp_neg(" + value + ", " + std::to_string(node->get_line_num()) + ");");
+}
+
+void CEmitter::visit(BinaryOperatorNode * node)
+{
+    std::string first = emit_operand(node->get_first_expr());
+    std::string second = emit_operand(node->get_second_expr());
+    std::string line = std::to_string(node->get_line_num());
+    std::string value;
+
+    switch (node->get_type())
+    {
+        case BinaryOperatorType::PLUS:
+            value = "pp_add(" + first + ", " + second + ", " + line + ")";
+            break;
+        case BinaryOperatorType::MINUS:
+            value = "pp_sub(" + first + ", " + second + ", " + line + ")";
+            break;
+        case BinaryOperatorType::MULTIPLY:
+            value = "pp_mul(" + first + ", " + second + ", " + line + ")";
+            break;
+        case BinaryOperatorType::DIVIDE:
+        {
+            LiteralNode * divisor = node_cast<LiteralNode>(node->get_second_expr());
+            if (divisor == nullptr || divisor->get_value() == 0)
+            {
+                emit_line("if (" + second + " == 0)");
+                emit_line("    pp_fail(" + line + ", \"division by zero\");");
+            }
+
+            //the minimum divided by -1 is the one quotient that overflows
+            if (divisor == nullptr || divisor->get_value() == -1)
+            {
+                emit_line("if (" + second + " == -1 && " + first + " == INT64_MIN)");
+                emit_line("    pp_fail(" + line + ", pp_overflow);");
+            }
+
+            value = first + " / " + second;
+            break;
+        }
+        case BinaryOperatorType::EQUALS:
+            value = first + " == " + second;
+            break;
+        case BinaryOperatorType::NOT_EQUALS:
+            value = first + " != " + second;
+            break;
+        case BinaryOperatorType::LESS:
+            value = first + " < " + second;
+            break;
+        case BinaryOperatorType::LESS_OR_EQALS:
+            value = first + " <= " + second;
+            break;
+        case BinaryOperatorType::MORE:
+            value = first + " > " + second;
+            break;
+        case BinaryOperatorType::MORE_OR_EQUALS:
+            value = first + " >= " + second;
+            break;
+    }
+
+    result_ = new_temp();
+    emit_line("pp_value_t " + result_ + " = " + value + ";");
+}
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <map>
+#include <set>
+#include "pp.h"
+#include "ast.h"
+#include "ast_visitor.h"
+#include "compiler.h"
+
+#ifndef C_EMITTER_H
+#define C_EMITTER_H
+
+/*
+ * Translates the resolved program into a standalone C program with the same
+ * output and runtime errors as the interpreter. Values wrap around as 32-bit
+ * ints, every operand is evaluated into a temporary of its own since C leaves
+ * the order of evaluation unspecified, and `return f(...)` becomes a C tail call,
+ * which the C compiler turns into a jump when optimizing
+ */
+class CEmitter : public ASTNodeVisitor
+{
+    public:
+        CEmitter(std::ostream & os, size_t max_depth) :
+            os_(os),
+            max_depth_(max_depth),
+            root_(nullptr),
+            function_(nullptr),
+            analyzer_(nullptr),
+            is_main_(false),
+            indent_(0),
+            next_temp_(0)
+        {}
+
+        void emit(ASTNodePtr root, std::string const & source_name);
+
+        virtual void visit(RootNode * node) override;
+        virtual void visit(FunctionDefinitionNode * node) override;
+        virtual void visit(AssignmentNode * node) override;
+        virtual void visit(FunctionCallNode * node) override;
+        virtual void visit(IfStatementNode * node) override;
+        virtual void visit(WhileStatementNode * node) override;
+        virtual void visit(PrintNode * node) override;
+        virtual void visit(ReadNode * node) override;
+        virtual void visit(ReturnNode * node) override;
+        virtual void visit(VariableNode * node) override;
+        virtual void visit(LiteralNode * node) override;
+        virtual void visit(UnaryMinusNode * node) override;
+        virtual void visit(BinaryOperatorNode * node) override;
+
+        //spawned calls need the threads of the tree engine
+        virtual void visit(SpawnNode * node) override;
+        virtual void visit(SyncNode * node) override;
+
+    private:
+        /*
+         * emits the code computing the expression,
+         * returns C expression of its value free of side effects
+         */
+        std::string emit_operand(ASTNodePtr node)
+        {
+            node->accept(this);
+            return result_;
+        }
+
+        void emit_sequence(StatementsSequence const & statements);
+        void emit_block(StatementsSequence const & statements);
+        void emit_function(FunctionDefinitionNode * node);
+
+        /*
+         * returns the call expression, or an empty string if the call always fails
+         */
+        std::string emit_call(FunctionCallNode * node, bool check_depth);
+
+        void emit_line(std::string const & code);
+        void emit_fail(std::string const & msg, ASTNode const * node);
+        std::string new_temp();
+
+        std::string local_name(int slot) const;
+        std::string global_name(int slot) const;
+        bool is_checked_global(StringRef name) const { return checked_globals_.count(name.str()) != 0; }
+
+        static std::string literal(pp_value_t value);
+
+        std::ostream & os_;
+        size_t max_depth_;
+        RootNode * root_;
+        //the definition each name is bound to, the last one
+        std::map<std::string, FunctionDefinitionNode *> functions_;
+        std::set<std::string> checked_globals_;
+
+        FunctionDefinitionNode * function_;
+        VariablesAnalyzer const * analyzer_;
+        bool is_main_;
+        std::ostringstream body_;
+        size_t indent_;
+        size_t next_temp_;
+        std::string result_;
+};
+
+#endif //C_EMITTER_H
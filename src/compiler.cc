@@ -0,0 +1,536 @@
+#include <cstdint>
+#include "compiler.h"
+
+template<class T>
+static T * node_cast(ASTNodePtr const & node)
+{
+    return dynamic_cast<T *>(&*node);
+}
+
+void VariablesAnalyzer::analyze(StatementsSequence const & statements, NamesSequence const & params)
+{
+    for (StringRef param : params)
+    {
+        definitely_assigned_.insert(param.str());
+    }
+
+    analyze_block(statements);
+}
+
+/*
+ * Assignments made inside of a block may never happen,
+ * so they're forgotten when the block ends
+ */
+void VariablesAnalyzer::analyze_block(StatementsSequence const & statements)
+{
+    std::set<std::string> saved = definitely_assigned_;
+
+    for (ASTNodePtr const & statement : statements)
+    {
+        statement->accept(this);
+    }
+
+    definitely_assigned_.swap(saved);
+}
+
+void VariablesAnalyzer::visit(RootNode *)
+{
+}
+
+void VariablesAnalyzer::visit(FunctionDefinitionNode *)
+{
+}
+
+void VariablesAnalyzer::visit(AssignmentNode * node)
+{
+    node->get_expr()->accept(this);
+    definitely_assigned_.insert(node->get_var_name().str());
+}
+
+void VariablesAnalyzer::visit(FunctionCallNode * node)
+{
+    for (ASTNodePtr const & param : node->get_params())
+    {
+        param->accept(this);
+    }
+}
+
+void VariablesAnalyzer::visit(IfStatementNode * node)
+{
+    node->get_expr()->accept(this);
+    analyze_block(node->get_statements());
+}
+
+void VariablesAnalyzer::visit(WhileStatementNode * node)
+{
+    node->get_expr()->accept(this);
+    analyze_block(node->get_statements());
+}
+
+void VariablesAnalyzer::visit(PrintNode * node)
+{
+    node->get_expr()->accept(this);
+}
+
+void VariablesAnalyzer::visit(ReadNode * node)
+{
+    definitely_assigned_.insert(node->get_var_name().str());
+}
+
+void VariablesAnalyzer::visit(ReturnNode * node)
+{
+    node->get_expr()->accept(this);
+}
+
+void VariablesAnalyzer::visit(VariableNode * node)
+{
+    std::string name = node->get_var_name().str();
+
+    if (definitely_assigned_.count(name) == 0)
+    {
+        checked_reads_.insert(node);
+        checked_names_.insert(name);
+    }
+}
+
+void VariablesAnalyzer::visit(LiteralNode *)
+{
+}
+
+void VariablesAnalyzer::visit(UnaryMinusNode * node)
+{
+    node->get_expr()->accept(this);
+}
+
+void VariablesAnalyzer::visit(BinaryOperatorNode * node)
+{
+    node->get_first_expr()->accept(this);
+    node->get_second_expr()->accept(this);
+}
+
+BytecodeProgram Compiler::compile(ASTNodePtr root)
+{
+    program_ = BytecodeProgram();
+    root->accept(this);
+
+    return program_;
+}
+
+void Compiler::visit(RootNode * node)
+{
+    StatementsSequence const & functions = node->get_functions();
+    std::vector<VariablesAnalyzer> analyzers(functions.size());
+
+    VariablesAnalyzer main_analyzer;
+    main_analyzer.analyze(node->get_statements(), NamesSequence());
+    checked_globals_ = main_analyzer.get_checked_names();
+
+    program_.functions.resize(functions.size());
+
+    for (size_t i = 0; i < functions.size(); i++)
+    {
+        FunctionDefinitionNode * function = node_cast<FunctionDefinitionNode>(functions[i]);
+
+        analyzers[i].analyze(function->get_statements(), function->get_params());
+        checked_globals_.insert(analyzers[i].get_checked_names().begin(), analyzers[i].get_checked_names().end());
+
+        program_.functions[i].params_num = function->get_params().size();
+        functions_[function->get_name().str()] = i;
+    }
+
+    for (size_t i = 0; i < functions.size(); i++)
+    {
+        FunctionDefinitionNode * function = node_cast<FunctionDefinitionNode>(functions[i]);
+
+        program_.functions[i].name = function->get_name().str();
+        compile_function(program_.functions[i], function->get_statements(), function->get_params().size(),
+                         function->get_slot_names(), analyzers[i]);
+    }
+
+    is_main_ = true;
+    compile_function(program_.main, node->get_statements(), 0, node->get_slot_names(), main_analyzer);
+}
+
+void Compiler::visit(FunctionDefinitionNode *)
+{
+    //functions are compiled from RootNode
+}
+
+void Compiler::compile_function(FunctionCode & code, StatementsSequence const & statements, size_t params_num,
+                                NamesSequence const & slot_names, VariablesAnalyzer const & analyzer)
+{
+    code_ = &code;
+    analyzer_ = &analyzer;
+
+    code.params_num = params_num;
+    code.variables_num = slot_names.size();
+    code.slot_names.clear();
+    for (StringRef name : slot_names)
+    {
+        code.slot_names.push_back(name.str());
+    }
+
+    next_temp_ = code.variables_num;
+    code.frame_size = next_temp_;
+
+    compile_sequence(statements);
+    emit(is_main_ ? OpCode::HALT : OpCode::RET0, 0, 0, 0, nullptr);
+}
+
+void Compiler::compile_sequence(StatementsSequence const & statements)
+{
+    for (ASTNodePtr const & statement : statements)
+    {
+        statement->accept(this);
+    }
+}
+
+size_t Compiler::emit(OpCode op, int32_t a, int32_t b, int32_t c, ASTNode const * node)
+{
+    code_->code.push_back(Instruction{op, a, b, c});
+    code_->lines.push_back(node != nullptr ? node->get_line_num() : 0);
+
+    return code_->code.size() - 1;
+}
+
+/*
+ * Jump target is the last operand of every jump instruction
+ */
+void Compiler::patch_jump(size_t index)
+{
+    Instruction & instruction = code_->code[index];
+    int32_t target = code_->code.size();
+
+    switch (instruction.op)
+    {
+        case OpCode::JMP:
+            instruction.a = target;
+            break;
+        case OpCode::JMPIFNOT:
+            instruction.b = target;
+            break;
+        default:
+            instruction.c = target;
+    }
+}
+
+void Compiler::emit_fail(std::string const & msg, ASTNode const * node)
+{
+    program_.messages.push_back(msg);
+    emit(OpCode::FAIL, program_.messages.size() - 1, 0, 0, node);
+}
+
+int Compiler::alloc_temp()
+{
+    int result = next_temp_++;
+
+    if (static_cast<size_t>(next_temp_) > code_->frame_size)
+    {
+        code_->frame_size = next_temp_;
+    }
+
+    return result;
+}
+
+/*
+ * Register the currently visited expression should be stored to
+ */
+int Compiler::target_register()
+{
+    result_ = dst_ >= 0 ? dst_ : alloc_temp();
+
+    return result_;
+}
+
+void Compiler::store_variable(int slot, ASTNode const * node)
+{
+    std::string const & name = code_->slot_names[slot];
+    bool checked = is_main_ ? checked_globals_.count(name) : analyzer_->get_checked_names().count(name);
+
+    if (checked)
+    {
+        emit(OpCode::DEFINE, slot, 0, 0, node);
+    }
+}
+
+/*
+ * Evaluates node into some register, variables that are known to be set are used in place
+ */
+int Compiler::compile_operand(ASTNodePtr node)
+{
+    int saved_dst = dst_;
+    dst_ = -1;
+    node->accept(this);
+    dst_ = saved_dst;
+
+    return result_;
+}
+
+void Compiler::compile_into(ASTNodePtr node, int dst)
+{
+    int saved_dst = dst_;
+    dst_ = dst;
+    node->accept(this);
+    dst_ = saved_dst;
+}
+
+void Compiler::compile_condition(ASTNodePtr expr, size_t & jump_index)
+{
+    int mark = next_temp_;
+    BinaryOperatorNode * binary = node_cast<BinaryOperatorNode>(expr);
+
+    if (binary != nullptr && binary->get_type() >= BinaryOperatorType::EQUALS)
+    {
+        int first = compile_operand(binary->get_first_expr());
+        int second = compile_operand(binary->get_second_expr());
+        OpCode op = OpCode::JEQ;
+
+        switch (binary->get_type())
+        {
+            case BinaryOperatorType::EQUALS:         op = OpCode::JEQ; break;
+            case BinaryOperatorType::NOT_EQUALS:     op = OpCode::JNE; break;
+            case BinaryOperatorType::LESS:           op = OpCode::JLT; break;
+            case BinaryOperatorType::LESS_OR_EQALS:  op = OpCode::JLE; break;
+            case BinaryOperatorType::MORE:           op = OpCode::JGT; break;
+            case BinaryOperatorType::MORE_OR_EQUALS: op = OpCode::JGE; break;
+            default: break;
+        }
+
+        jump_index = emit(op, first, second, 0, binary);
+    }
+    else
+    {
+        int condition = compile_operand(expr);
+        jump_index = emit(OpCode::JMPIFNOT, condition, 0, 0, &*expr);
+    }
+
+    next_temp_ = mark;
+}
+
+void Compiler::visit(AssignmentNode * node)
+{
+    int slot = node->get_slot();
+
+    compile_into(node->get_expr(), slot);
+    store_variable(slot, node);
+}
+
+void Compiler::visit(FunctionCallNode * node)
+{
+    compile_call(node, false);
+}
+
+/*
+ * a tail call replaces the current frame and doesn't produce a value
+ */
+void Compiler::compile_call(FunctionCallNode * node, bool tail)
+{
+    int mark = next_temp_;
+    std::string func_name = node->get_name().str();
+    auto function = functions_.find(func_name);
+
+    if (function == functions_.end())
+    {
+        emit_fail("undefined function " + func_name, node);
+        if (!tail)
+        {
+            target_register();
+        }
+        return;
+    }
+
+    FunctionCode const & callee = program_.functions[function->second];
+    size_t params_num = node->get_params().size();
+
+    if (callee.params_num != params_num)
+    {
+        emit_fail("arguments number mismatch for " + func_name, node);
+        if (!tail)
+        {
+            target_register();
+        }
+        return;
+    }
+
+    int args_base = next_temp_;
+    for (size_t i = 0; i < params_num; i++)
+    {
+        alloc_temp();
+    }
+
+    for (size_t i = 0; i < params_num; i++)
+    {
+        int mark_arg = next_temp_;
+        compile_into(node->get_params()[i], args_base + i);
+        next_temp_ = mark_arg;
+    }
+
+    next_temp_ = mark;
+
+    if (tail)
+    {
+        emit(OpCode::TAILCALL, 0, function->second, args_base, node);
+    }
+    else
+    {
+        emit(OpCode::CALL, target_register(), function->second, args_base, node);
+    }
+}
+
+void Compiler::visit(IfStatementNode * node)
+{
+    size_t jump_index;
+    compile_condition(node->get_expr(), jump_index);
+    compile_sequence(node->get_statements());
+    patch_jump(jump_index);
+}
+
+void Compiler::visit(WhileStatementNode * node)
+{
+    int32_t loop_start = code_->code.size();
+    size_t jump_index;
+
+    compile_condition(node->get_expr(), jump_index);
+    compile_sequence(node->get_statements());
+    emit(OpCode::JMP, loop_start, 0, 0, node);
+    patch_jump(jump_index);
+}
+
+void Compiler::visit(PrintNode * node)
+{
+    int mark = next_temp_;
+    emit(OpCode::PRINT, compile_operand(node->get_expr()), 0, 0, node);
+    next_temp_ = mark;
+}
+
+void Compiler::visit(ReadNode * node)
+{
+    int slot = node->get_slot();
+
+    emit(OpCode::READ, slot, 0, 0, node);
+    store_variable(slot, node);
+}
+
+void Compiler::visit(SpawnNode * node)
+{
+    throw CompilerException(node->get_line_num(), "spawn is supported by the tree engine only");
+}
+
+void Compiler::visit(SyncNode * node)
+{
+    throw CompilerException(node->get_line_num(), "sync is supported by the tree engine only");
+}
+
+void Compiler::visit(ReturnNode * node)
+{
+    int mark = next_temp_;
+
+    if (!is_main_ && node->is_tail_call())
+    {
+        compile_call(static_cast<FunctionCallNode *>(node->get_expr()), true);
+    }
+    else
+    {
+        int value = compile_operand(node->get_expr());
+        emit(is_main_ ? OpCode::HALT : OpCode::RET, value, 0, 0, node);
+    }
+
+    next_temp_ = mark;
+}
+
+void Compiler::visit(VariableNode * node)
+{
+    int local = node->get_slot();
+    int global = node->get_global_slot();
+
+    if (local >= 0 && !analyzer_->is_checked_read(node))
+    {
+        if (dst_ < 0)
+        {
+            result_ = local;
+        }
+        else
+        {
+            emit(OpCode::MOVE, target_register(), local, 0, node);
+        }
+    }
+    else if (local >= 0)
+    {
+        emit(OpCode::GETVAR, target_register(), local, global, node);
+    }
+    else if (global >= 0)
+    {
+        emit(OpCode::GETGLOBAL, target_register(), global, 0, node);
+    }
+    else
+    {
+        emit_fail("undefined variable " + node->get_var_name(), node);
+        target_register();
+    }
+}
+
+/*
+ * instructions take 32-bit immediates, wider literals are constants of the program
+ */
+static bool is_immediate(pp_value_t value)
+{
+    return value > INT32_MIN && value <= INT32_MAX;
+}
+
+void Compiler::visit(LiteralNode * node)
+{
+    if (is_immediate(node->get_value()))
+    {
+        emit(OpCode::LOADK, target_register(), node->get_value(), 0, node);
+        return;
+    }
+
+    program_.constants.push_back(node->get_value());
+    emit(OpCode::LOADC, target_register(), program_.constants.size() - 1, 0, node);
+}
+
+void Compiler::visit(UnaryMinusNode * node)
+{
+    int mark = next_temp_;
+    int value = compile_operand(node->get_expr());
+
+    next_temp_ = mark;
+    emit(OpCode::NEG, target_register(), value, 0, node);
+}
+
+void Compiler::visit(BinaryOperatorNode * node)
+{
+    int mark = next_temp_;
+    int first = compile_operand(node->get_first_expr());
+    LiteralNode * literal = node_cast<LiteralNode>(node->get_second_expr());
+
+    if (literal != nullptr && is_immediate(literal->get_value()) &&
+        (node->get_type() == BinaryOperatorType::PLUS || node->get_type() == BinaryOperatorType::MINUS))
+    {
+        pp_value_t value = literal->get_value();
+
+        next_temp_ = mark;
+        emit(OpCode::ADDK, target_register(), first, node->get_type() == BinaryOperatorType::PLUS ? value : -value, node);
+        return;
+    }
+
+    int second = compile_operand(node->get_second_expr());
+    OpCode op = OpCode::ADD;
+
+    switch (node->get_type())
+    {
+        case BinaryOperatorType::PLUS:           op = OpCode::ADD; break;
+        case BinaryOperatorType::MINUS:          op = OpCode::SUB; break;
+        case BinaryOperatorType::MULTIPLY:       op = OpCode::MUL; break;
+        case BinaryOperatorType::DIVIDE:         op = OpCode::DIV; break;
+        case BinaryOperatorType::EQUALS:         op = OpCode::EQ; break;
+        case BinaryOperatorType::NOT_EQUALS:     op = OpCode::NE; break;
+        case BinaryOperatorType::LESS:           op = OpCode::LT; break;
+        case BinaryOperatorType::LESS_OR_EQALS:  op = OpCode::LE; break;
+        case BinaryOperatorType::MORE:           op = OpCode::GT; break;
+        case BinaryOperatorType::MORE_OR_EQUALS: op = OpCode::GE; break;
+    }
+
+    next_temp_ = mark;
+    emit(op, target_register(), first, second, node);
+}
@@ -0,0 +1,115 @@
+#include <string>
+#include <map>
+#include <set>
+#include <vector>
+#include "pp.h"
+#include "ast.h"
+#include "ast_visitor.h"
+#include "bytecode.h"
+
+#ifndef COMPILER_H
+#define COMPILER_H
+
+/*
+ * A construct the bytecode and the C backends have no translation for
+ */
+class CompilerException : public LineNumberException
+{
+    public:
+        CompilerException(size_t line, std::string const & msg) :
+            LineNumberException(line, msg)
+        {}
+};
+
+/*
+ * Collects the reads of a function body (or the top level) that are not
+ * preceded by a definite assignment on every path,
+ * those are the only ones that need a runtime "is set" check
+ */
+class VariablesAnalyzer : public ASTNodeVisitor
+{
+    public:
+        void analyze(StatementsSequence const & statements, NamesSequence const & params);
+
+        bool is_checked_read(ASTNode const * node) const { return checked_reads_.count(node) != 0; }
+        std::set<std::string> const & get_checked_names() const { return checked_names_; }
+
+        virtual void visit(RootNode * node) override;
+        virtual void visit(FunctionDefinitionNode * node) override;
+        virtual void visit(AssignmentNode * node) override;
+        virtual void visit(FunctionCallNode * node) override;
+        virtual void visit(IfStatementNode * node) override;
+        virtual void visit(WhileStatementNode * node) override;
+        virtual void visit(PrintNode * node) override;
+        virtual void visit(ReadNode * node) override;
+        virtual void visit(ReturnNode * node) override;
+        virtual void visit(VariableNode * node) override;
+        virtual void visit(LiteralNode * node) override;
+        virtual void visit(UnaryMinusNode * node) override;
+        virtual void visit(BinaryOperatorNode * node) override;
+
+    private:
+        void analyze_block(StatementsSequence const & statements);
+
+        std::set<std::string> definitely_assigned_;
+        std::set<ASTNode const *> checked_reads_;
+        std::set<std::string> checked_names_;
+};
+
+class Compiler : public ASTNodeVisitor
+{
+    public:
+        Compiler() : code_(nullptr), analyzer_(nullptr), is_main_(false), next_temp_(0), dst_(-1), result_(-1) {}
+
+        BytecodeProgram compile(ASTNodePtr root);
+
+        virtual void visit(RootNode * node) override;
+        virtual void visit(FunctionDefinitionNode * node) override;
+        virtual void visit(AssignmentNode * node) override;
+        virtual void visit(FunctionCallNode * node) override;
+        virtual void visit(IfStatementNode * node) override;
+        virtual void visit(WhileStatementNode * node) override;
+        virtual void visit(PrintNode * node) override;
+        virtual void visit(ReadNode * node) override;
+        virtual void visit(ReturnNode * node) override;
+        virtual void visit(VariableNode * node) override;
+        virtual void visit(LiteralNode * node) override;
+        virtual void visit(UnaryMinusNode * node) override;
+        virtual void visit(BinaryOperatorNode * node) override;
+
+        //spawned calls need the threads of the tree engine
+        virtual void visit(SpawnNode * node) override;
+        virtual void visit(SyncNode * node) override;
+
+    private:
+        void compile_function(FunctionCode & code, StatementsSequence const & statements, size_t params_num,
+                              NamesSequence const & slot_names, VariablesAnalyzer const & analyzer);
+        void compile_sequence(StatementsSequence const & statements);
+        void compile_condition(ASTNodePtr expr, size_t & jump_index);
+        void compile_call(FunctionCallNode * node, bool tail);
+
+        int compile_operand(ASTNodePtr node);
+        void compile_into(ASTNodePtr node, int dst);
+
+        size_t emit(OpCode op, int32_t a, int32_t b, int32_t c, ASTNode const * node);
+        void patch_jump(size_t index);
+        void emit_fail(std::string const & msg, ASTNode const * node);
+
+        int alloc_temp();
+        int target_register();
+        void store_variable(int slot, ASTNode const * node);
+
+        BytecodeProgram program_;
+        std::map<std::string, size_t> functions_;
+        std::set<std::string> checked_globals_;
+
+        FunctionCode * code_;
+        VariablesAnalyzer const * analyzer_;
+        bool is_main_;
+        int next_temp_;
+
+        int dst_;
+        int result_;
+};
+
+#endif //COMPILER_H
@@ -1,66 +1,95 @@
-#include <memory>
-#include <map>
-#include <string>
+#include <cstring>
+#include <vector>
+#include <algorithm>
 #include "pp.h"
+#include "value.h"
 
 #ifndef CONTEXT_H
 #define CONTEXT_H
 
-class Context;
-
-typedef std::shared_ptr<Context> ContextPtr;
-
-class Context 
+/*
+ * Contiguous stack of variable frames indexed by slots assigned by Resolver.
+ * Frames are addressed by their base offset, so the storage may grow
+ * without invalidating them; it is allocated once and reused across calls
+ */
+class FrameStack
 {
     public:
-        Context() : parent_context_(nullptr) {}
-        Context(ContextPtr parent_context) :
-            parent_context_(parent_context) {}
-        
-        bool isset_variable(std::string const & name) const 
+        static const size_t initial_capacity = 1 << 16;
+
+        FrameStack() :
+            values_(initial_capacity),
+            defined_(initial_capacity),
+            top_(0)
+        {}
+
+        /*
+         * returns base of the new frame with all slots undefined
+         */
+        size_t push_frame(size_t slots_num)
         {
-            if (isset_variable_local(name)) 
-            {
-                return true;
-            }
-            
-            if (parent_context_ != nullptr) 
+            size_t base = top_;
+            top_ += slots_num;
+
+            if (top_ > values_.size())
             {
-                return parent_context_->isset_variable(name);
+                values_.resize(2 * top_);
+                defined_.resize(2 * top_);
             }
 
-            return false;
+            std::memset(&defined_[0] + base, 0, slots_num);
+            return base;
         }
-         
-        pp_value_t get_var_value(std::string name)
+
+        void pop_frame(size_t base)
         {
-            if (isset_variable_local(name)) 
-            {
-                return variables_[name];
-            }
-            
-            if (parent_context_ != nullptr) 
-            {
-                return parent_context_->get_var_value(name);
-            }
-            
-            return 0;
+            top_ = base;
         }
 
-        void set_var_value(std::string name, pp_value_t value) 
+        /*
+         * moves the frame down to the base of an older one,
+         * which is dropped along with every frame between them
+         */
+        void move_frame(size_t from_base, size_t to_base, size_t slots_num)
         {
-            variables_[name] = value;
+            std::move(values_.begin() + from_base, values_.begin() + from_base + slots_num, values_.begin() + to_base);
+            std::memmove(&defined_[0] + to_base, &defined_[0] + from_base, slots_num);
+            top_ = to_base + slots_num;
         }
 
-    private:
-        bool isset_variable_local(std::string const & name) const 
+        /*
+         * slots of the frame, valid until the next frame is pushed
+         */
+        Value const * get_frame(size_t base) const
         {
-            return variables_.count(name) != 0;
+            return &values_[0] + base;
         }
 
-        std::map<std::string, pp_value_t> variables_;
-        ContextPtr parent_context_;
+        void clear()
+        {
+            top_ = 0;
+        }
+
+        bool isset_variable(size_t base, int slot) const
+        {
+            return defined_[base + slot];
+        }
+
+        Value const & get_var_value(size_t base, int slot) const
+        {
+            return values_[base + slot];
+        }
+
+        void set_var_value(size_t base, int slot, Value const & value)
+        {
+            values_[base + slot] = value;
+            defined_[base + slot] = true;
+        }
+
+    private:
+        std::vector<Value> values_;
+        std::vector<unsigned char> defined_;
+        size_t top_;
 };
 
 #endif //CONTEXT_H
-
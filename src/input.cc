@@ -0,0 +1,119 @@
+#include <cerrno>
+#include <cctype>
+#include <unistd.h>
+#include "input.h"
+
+std::string InputReader::error_message(ReadResult result)
+{
+    switch (result)
+    {
+        case ReadResult::END_OF_INPUT:
+            return "unexpected end of input";
+        case ReadResult::INVALID_NUMBER:
+            return "invalid number in input";
+        default:
+            return "";
+    }
+}
+
+bool InputReader::fill()
+{
+    position_ = 0;
+    size_ = 0;
+
+    while (!eof_)
+    {
+        ssize_t result = ::read(fd_, buffer_.data(), buffer_.size());
+
+        if (result > 0)
+        {
+            size_ = result;
+            return true;
+        }
+
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        //read errors are treated as the end of input
+        eof_ = true;
+    }
+
+    return false;
+}
+
+/*
+ * Accepts the same format as operator>> for integers: leading whitespaces,
+ * optional sign and digits, but the number has to end with a whitespace.
+ * Numbers of any length are read, the ones beyond pp_value_t become big
+ */
+ReadResult InputReader::read(Value & value)
+{
+    int c = peek();
+
+    while (c != -1 && isspace(c))
+    {
+        position_++;
+        c = peek();
+    }
+
+    if (c == -1)
+    {
+        return ReadResult::END_OF_INPUT;
+    }
+
+    bool negative = false;
+    if (c == '-' || c == '+')
+    {
+        negative = c == '-';
+        position_++;
+        c = peek();
+    }
+
+    if (c == -1 || !isdigit(c))
+    {
+        return ReadResult::INVALID_NUMBER;
+    }
+
+    //accumulated as negative to fit the minimum, once it overflows the digits are collected
+    pp_value_t result = 0;
+    std::string digits;
+
+    while (c != -1 && isdigit(c))
+    {
+        pp_value_t next;
+
+        if (!digits.empty())
+        {
+            digits += static_cast<char>(c);
+        }
+        else if (!__builtin_mul_overflow(result, 10, &next) && !__builtin_sub_overflow(next, c - '0', &next))
+        {
+            result = next;
+        }
+        else
+        {
+            digits = std::to_string(result).substr(1) + static_cast<char>(c);
+        }
+
+        position_++;
+        c = peek();
+    }
+
+    if (c != -1 && !isspace(c))
+    {
+        return ReadResult::INVALID_NUMBER;
+    }
+
+    if (!digits.empty())
+    {
+        value = Value::of(BigInt::from_decimal(negative, digits));
+    }
+    else
+    {
+        value = negative ? Value(result) : -Value(result);
+    }
+
+    return ReadResult::OK;
+}
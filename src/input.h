@@ -0,0 +1,73 @@
+#include <string>
+#include <vector>
+#include "pp.h"
+#include "value.h"
+
+#ifndef INPUT_H
+#define INPUT_H
+
+enum class ReadResult
+{
+    OK, END_OF_INPUT, INVALID_NUMBER
+};
+
+const size_t input_buffer_size = 1 << 20;
+
+/*
+ * Reader of whitespace separated integers for the read statement,
+ * fills the buffer with read(2) or reads memory of the caller in place,
+ * and parses numbers by hand
+ */
+class InputReader
+{
+    public:
+        explicit
+        InputReader(int fd) :
+            fd_(fd),
+            position_(0),
+            size_(0),
+            eof_(false),
+            buffer_(input_buffer_size),
+            data_(buffer_.data())
+        {}
+
+        InputReader(char const * memory, size_t size) :
+            fd_(-1),
+            position_(0),
+            size_(size),
+            eof_(true),
+            data_(memory)
+        {}
+
+        ReadResult read(Value & value);
+
+        static std::string error_message(ReadResult result);
+
+        InputReader &operator=(InputReader const &a) = delete;
+        InputReader(InputReader const &a) = delete;
+
+    private:
+        /*
+         * returns -1 at the end of input
+         */
+        int peek()
+        {
+            if (position_ == size_ && !fill())
+            {
+                return -1;
+            }
+
+            return static_cast<unsigned char>(data_[position_]);
+        }
+
+        bool fill();
+
+        int fd_;
+        size_t position_;
+        size_t size_;
+        bool eof_;
+        std::vector<char> buffer_;
+        char const * data_;
+};
+
+#endif //INPUT_H
@@ -1,75 +1,329 @@
-#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <thread>
 #include "interpreter.h"
 
 void Interpreter::execute(ASTNodePtr root)
 {
-    root_context_ = ContextPtr(new Context());
-    contexts_stack_.push_back(root_context_);
-
+    start();
     root->accept(this);
     clear();
 }
 
-void Interpreter::visit(RootNode * node)
+void Interpreter::start()
+{
+    native_stack_limit_ = native_stack_limit(native_stack_reserve);
+    memos_.clear();
+
+    if (jit_enabled_)
+    {
+        JitRuntime runtime = {this, &depth_, max_depth_, native_stack_limit_, &jit_failed_, &Interpreter::jit_fail};
+        jit_.reset(new JitCompiler(runtime, jit_log_));
+    }
+}
+
+void Interpreter::begin(RootNode * root)
+{
+    start();
+    define_functions(root);
+}
+
+void Interpreter::end()
 {
+    //the program waits for its spawned calls
+    sync_spawns();
+    clear();
+}
+
+bool Interpreter::execute_statement(ASTNodePtr statement)
+{
+    statement->accept(this);
+
+    //return at the top level stops the program
+    return !was_return_;
+}
+
+void Interpreter::define_functions(RootNode * node)
+{
+    root_ = node;
+    frame_base_ = frames_.push_frame(node->get_slot_names().size());
+    functions_.assign(node->get_functions().size(), nullptr);
+
     for (const ASTNodePtr & function : node->get_functions())
     {
         function->accept(this);
     }
+}
+
+void Interpreter::visit(RootNode * node)
+{
+    define_functions(node);
 
     for (const ASTNodePtr & statement : node->get_statements()) 
     {
-        statement->accept(this);
+        if (!execute_statement(statement)) 
+        {
+            break;
+        }
     }
+
+    //the program waits for its spawned calls
+    was_return_ = false;
+    sync_spawns();
 }
 
 void Interpreter::visit(FunctionDefinitionNode * node)
 {
-    FunctionDefinitionPtr function(new FunctionDefinition(node->get_name(), node->get_params(), node->get_statements()));
+    FunctionDefinitionPtr function(new FunctionDefinition(
+        node->get_name(), node->get_params(), node->get_statements(), node->get_slot_names().size()
+    ));
+
+    if (memoize_ && node->is_pure())
+    {
+        auto memo = memos_.emplace(node->get_name(), MemoCache(node->get_params().size())).first;
+        function->set_memo(&memo->second);
+    }
+
+    if (jit_enabled_)
+    {
+        //compiled callers get to the function through the interpreter until it's compiled itself
+        function->get_jit().entry = &Interpreter::jit_interpret;
+    }
 
-    functions_[node->get_name()] = function;
+    functions_[node->get_index()] = function;
 }
 
 void Interpreter::visit(AssignmentNode * node)
 {
-    std::string var_name = node->get_var_name();
-    current_context()->set_var_value(var_name, value_of(node->get_expr()));
+    frames_.set_var_value(frame_base_, node->get_slot(), value_of(node->get_expr()));
 }
 
-void Interpreter::visit(FunctionCallNode * node)
+/*
+ * the frame is reserved first, so calls made while evaluating
+ * arguments in the current frame are stacked above it
+ */
+size_t Interpreter::push_arguments(FunctionCallNode const * node, FunctionDefinition const & function)
 {
-    std::string func_name = node->get_name();
+    size_t base = frames_.push_frame(function.get_slots_num());
 
-    assert_runtime_error(
-        functions_.count(func_name), 
-        "undefined function " + func_name, 
-        node
-    );
+    //parameters occupy the first slots
+    for (size_t i = 0; i < node->get_params().size(); i++) 
+    {
+        frames_.set_var_value(base, i, value_of(node->get_params()[i]));
+    }
 
-    FunctionDefinition function = *(functions_[func_name]);
-    assert_runtime_error(
-        function.get_params().size() == node->get_params().size(), 
-        "arguments number mismatch for " + func_name, 
-        node
-    );
-    
-    ContextPtr func_context(new Context(root_context_));    
-    
-    for (size_t i = 0; i < function.get_params().size(); i++) 
+    return base;
+}
+
+void Interpreter::visit(FunctionCallNode * node)
+{
+    FunctionDefinition * function = &find_function(node);
+
+    char native_stack_marker;
+    if (depth_ >= max_depth_ || &native_stack_marker < native_stack_limit_)
     {
-        func_context->set_var_value(
-            function.get_params()[i],
-            value_of(node->get_params()[i])
-        );
+        throw_error("maximum call depth exceeded", node);
     }
     
-    contexts_stack_.push_back(func_context);
-    
-    execute_sequence(function.get_statements(), true);
-    contexts_stack_.pop_back();
+    size_t callee_base = push_arguments(node, *function);
+
+    MemoCache * memo = function->get_memo();
+    size_t memo_args = memo_args_.size();
+    if (memo != nullptr)
+    {
+        Value const * args = frames_.get_frame(callee_base);
+
+        if (memo->find(args, last_value_))
+        {
+            frames_.pop_frame(callee_base);
+            return;
+        }
+
+        memo_args_.insert(memo_args_.end(), args, args + function->get_params().size());
+    }
+
+    depth_++;
+    run_function(function, callee_base);
+    depth_--;
+
+    if (memo != nullptr)
+    {
+        //functions it tail called are pure as well, so the result is still the function's
+        memo->insert(memo_args_.data() + memo_args, last_value_);
+        memo_args_.resize(memo_args);
+    }
+}
+
+/*
+ * runs the function in the frame pushed for it, the frame is popped after
+ */
+void Interpreter::run_function(FunctionDefinition * function, size_t callee_base)
+{
+    size_t caller_base = frame_base_;
+    size_t caller_spawns_base = spawns_base_;
+    frame_base_ = callee_base;
+    spawns_base_ = spawns_.size();
+
+    while (true)
+    {
+        if (jit_ != nullptr && is_compiled(function) && run_compiled(function, callee_base))
+        {
+            break;
+        }
+
+        if (!execute_sequence(function->get_statements(), true))
+        {
+            //no return statement, function's value is 0
+            last_value_ = 0;
+            break;
+        }
+
+        if (tail_call_ == nullptr)
+        {
+            break;
+        }
+
+        //return f(...) runs f in place of the returning function
+        FunctionCallNode const * call = tail_call_;
+        tail_call_ = nullptr;
+        function = &find_function(call);
+
+        size_t next_base = push_arguments(call, *function);
+
+        if (spawns_.size() != spawns_base_)
+        {
+            sync_spawns();
+        }
+
+        frames_.move_frame(next_base, callee_base, function->get_slots_num());
+    }
+
+    //the function waits for its spawned calls, its value is kept
+    if (spawns_.size() != spawns_base_)
+    {
+        sync_spawns();
+    }
+
+    frame_base_ = caller_base;
+    spawns_base_ = caller_spawns_base;
+    frames_.pop_frame(callee_base);
+}
+
+/*
+ * counts the call and compiles the function once it's hot
+ */
+bool Interpreter::is_compiled(FunctionDefinition * function)
+{
+    JitState & state = function->get_jit();
+
+    if (!state.compiled && !state.rejected && ++state.calls >= JitCompiler::threshold)
+    {
+        state.rejected = !jit_->compile(function);
+    }
+
+    return state.compiled;
+}
+
+/*
+ * errors of compiled code are thrown from here. Returns false if the call is left
+ * to the interpreter, as compiled code can't hold a value of it; compiled code
+ * calls pure functions only, so making the call again has the same effect
+ */
+bool Interpreter::run_compiled(FunctionDefinition * function, size_t base)
+{
+    Value const * frame = frames_.get_frame(base);
+    size_t args = jit_args_.size();
+
+    //compiled code copies its arguments first, so nested calls may move them
+    for (size_t i = 0; i < function->get_params().size(); i++)
+    {
+        if (!frame[i].is_small())
+        {
+            jit_args_.resize(args);
+            return false;
+        }
+
+        jit_args_.push_back(frame[i].get_small());
+    }
+
+    pp_value_t value = function->get_jit().entry(jit_args_.data() + args, function, this);
+    jit_args_.resize(args);
+
+    if (jit_failed_)
+    {
+        jit_failed_ = false;
+
+        if (jit_overflow_)
+        {
+            //values of the function outgrow compiled code, it's interpreted from now on
+            jit_overflow_ = false;
+            JitState & state = function->get_jit();
+            state.entry = &Interpreter::jit_interpret;
+            state.compiled = false;
+            state.rejected = true;
+
+            return false;
+        }
+
+        std::rethrow_exception(jit_exception_);
+    }
+
+    last_value_ = value;
+    return true;
 }
 
-void Interpreter::execute_sequence(StatementsSequence const & statements, bool within_function) 
+/*
+ * entry of the functions compiled code calls before they are compiled.
+ * Exceptions can't pass through compiled code, so they wait for the interpreter
+ * frame the compiled code returns to
+ */
+pp_value_t Interpreter::jit_interpret(pp_value_t const * args, FunctionDefinition * function, Interpreter * self)
+{
+    try
+    {
+        size_t base = self->frames_.push_frame(function->get_slots_num());
+        for (size_t i = 0; i < function->get_params().size(); i++)
+        {
+            self->frames_.set_var_value(base, i, args[i]);
+        }
+
+        self->run_function(function, base);
+
+        if (!self->last_value_.is_small())
+        {
+            self->jit_overflow_ = true;
+            self->jit_failed_ = true;
+            return 0;
+        }
+
+        return self->last_value_.get_small();
+    }
+    catch (...)
+    {
+        self->jit_exception_ = std::current_exception();
+        self->jit_failed_ = true;
+        return 0;
+    }
+}
+
+void Interpreter::jit_fail(Interpreter * self, char const * msg, size_t line)
+{
+    if (msg == JitCompiler::overflow)
+    {
+        self->jit_overflow_ = true;
+    }
+    else
+    {
+        self->jit_exception_ = std::make_exception_ptr(InterpreterRuntimeException(line, msg));
+    }
+
+    self->jit_failed_ = true;
+}
+
+/*
+ * returns true if the sequence was left by return statement
+ */
+bool Interpreter::execute_sequence(StatementsSequence const & statements, bool within_function) 
 {
     for (const ASTNodePtr & statement : statements)
     {
@@ -81,9 +335,11 @@ void Interpreter::execute_sequence(StatementsSequence const & statements, bool w
                was_return_ = false;
            }
 
-           return;
+           return true;
         }
     }
+
+    return false;
 }
 
 void Interpreter::visit(IfStatementNode * node)
@@ -108,33 +364,52 @@ void Interpreter::visit(WhileStatementNode * node)
 
 void Interpreter::visit(ReadNode * node)
 {
-    pp_value_t value;
-    std::cin >> value;
+    Value value;
+    ReadResult result = input_.read(value);
+
+    if (result != ReadResult::OK)
+    {
+        throw_error(InputReader::error_message(result), node);
+    }
 
-    current_context()->set_var_value(node->get_var_name(), value);
+    frames_.set_var_value(frame_base_, node->get_slot(), value);
 }
 
 void Interpreter::visit(PrintNode * node)
 {
-    std::cout << value_of(node->get_expr()) << std::endl;
+    output_.print(value_of(node->get_expr()));
+    assert_runtime_error(!output_.is_full(), "output buffer is full", node);
 }
 
 void Interpreter::visit(ReturnNode * node)
 {
-    last_value_ = value_of(node->get_expr());
+    if (is_tail_call(node))
+    {
+        //made by the function call loop once this frame is left
+        tail_call_ = static_cast<FunctionCallNode *>(node->get_expr());
+    }
+    else
+    {
+        last_value_ = value_of(node->get_expr());
+    }
+
     was_return_ = true;
 }
 
-void Interpreter::visit(VariableNode * node)
+Value const & Interpreter::global_value(VariableNode const * node)
 {
-    std::string var_name = node->get_var_name();
-    assert_runtime_error(
-        current_context()->isset_variable(var_name), 
-        "undefined variable " + var_name, 
-        node
-    );
+    int global_slot = node->get_global_slot();
+    if (global_slot == no_slot || !frames_.isset_variable(0, global_slot))
+    {
+        throw_error("undefined variable " + node->get_var_name(), node);
+    }
 
-    last_value_ = current_context()->get_var_value(var_name);
+    return frames_.get_var_value(0, global_slot);
+}
+
+void Interpreter::visit(VariableNode * node)
+{
+    last_value_ = variable_value(node);
 }
 
 void Interpreter::visit(LiteralNode * node)
@@ -149,50 +424,294 @@ void Interpreter::visit(UnaryMinusNode * node)
 
 void Interpreter::visit(BinaryOperatorNode * node)
 {
-    pp_value_t first_operand  = value_of(node->get_first_expr());
-    pp_value_t second_operand = value_of(node->get_second_expr());
+    Value first_operand  = value_of(node->get_first_expr());
+    Value second_operand = value_of(node->get_second_expr());
 
+    last_value_ = apply(node, first_operand, second_operand);
+}
 
-    switch (node->get_type()) 
+void Interpreter::visit(VariableLiteralOperatorNode * node)
+{
+    last_value_ = apply(node, variable_value(node->get_variable()), node->get_literal());
+}
+
+void Interpreter::visit(VariablesOperatorNode * node)
+{
+    last_value_ = apply(node, variable_value(node->get_first_variable()), variable_value(node->get_second_variable()));
+}
+
+/*
+ * operands of specialized comparisons are read without visiting them
+ */
+bool Interpreter::is_true(BinaryOperatorNode * condition, OperandsKind operands_kind)
+{
+    switch (operands_kind)
     {
-        case BinaryOperatorType::PLUS:
-            last_value_ = first_operand + second_operand;
-            break;
-        case BinaryOperatorType::MINUS:
-            last_value_ = first_operand - second_operand;
-            break;
-        case BinaryOperatorType::MULTIPLY:
-            last_value_ = first_operand * second_operand;
-            break;
-        case BinaryOperatorType::DIVIDE:
-            assert_runtime_error(
-                second_operand != 0, 
-                "division by zero", 
-                node
-            );
-
-            last_value_ = first_operand / second_operand;
-            break;
-        case BinaryOperatorType::EQUALS:
-            last_value_ = first_operand == second_operand;
-            break;
-        case BinaryOperatorType::NOT_EQUALS:
-            last_value_ = first_operand != second_operand;
-            break;
-        case BinaryOperatorType::LESS:
-            last_value_ = first_operand < second_operand;
-            break;
-        case BinaryOperatorType::LESS_OR_EQALS:
-            last_value_ = first_operand <= second_operand;
-            break;
-        case BinaryOperatorType::MORE:
-            last_value_ = first_operand > second_operand;
-            break;
-        case BinaryOperatorType::MORE_OR_EQUALS:
-            last_value_ = first_operand >= second_operand;
-            break;
+        case OperandsKind::VARIABLE_LITERAL:
+        {
+            VariableLiteralOperatorNode * node = static_cast<VariableLiteralOperatorNode *>(condition);
+            return compare(condition, variable_value(node->get_variable()), node->get_literal());
+        }
+        case OperandsKind::VARIABLES:
+        {
+            VariablesOperatorNode * node = static_cast<VariablesOperatorNode *>(condition);
+            return compare(condition, variable_value(node->get_first_variable()), variable_value(node->get_second_variable()));
+        }
         default:
-            throw_error("unknown operator type", node);
+        {
+            Value first_operand = value_of(condition->get_first_expr());
+            Value second_operand = value_of(condition->get_second_expr());
+
+            return compare(condition, first_operand, second_operand);
+        }
+    }
+}
+
+void Interpreter::visit(CompareIfNode * node)
+{
+    if (is_true(node->get_condition(), node->get_operands_kind()))
+    {
+        execute_sequence(node->get_statements());
+    }
+}
+
+void Interpreter::visit(CompareWhileNode * node)
+{
+    BinaryOperatorNode * condition = node->get_condition();
+    OperandsKind operands_kind = node->get_operands_kind();
+
+    while (is_true(condition, operands_kind))
+    {
+        execute_sequence(node->get_statements());
+        if (was_return_) 
+        {
+            return;
+        }
+    }
+}
+
+void Interpreter::visit(IncrementNode * node)
+{
+    last_value_ = variable_value(node->get_variable()) + node->get_delta();
+    frames_.set_var_value(frame_base_, node->get_slot(), last_value_);
+}
+
+/*
+ * arguments are evaluated here, the call is left to the pool. Calls which
+ * print, read or read globals are made in place, so they keep their order
+ * with the rest of the program; their results are assigned at sync all the same
+ */
+void Interpreter::visit(SpawnNode * node)
+{
+    FunctionCallNode * call = node->get_call();
+    bool pure = call->get_target()->is_pure();
+    std::unique_ptr<SpawnTask> task(new SpawnTask(call->get_target(), call->get_line_num(), depth_));
+
+    //pending once evaluated, so an error here leaves nothing to wait for
+    if (pure)
+    {
+        for (ASTNodePtr param : call->get_params())
+        {
+            task->args.push_back(value_of(param));
+        }
+    }
+    else
+    {
+        task->result = value_of(call);
+        task->done = true;
+    }
+
+    spawns_.push_back(PendingSpawn{node->get_slot(), std::move(task)});
+
+    if (pure)
+    {
+        spawn_pool().push(spawn_queue_, spawns_.back().task.get());
+    }
+}
+
+void Interpreter::visit(SyncNode *)
+{
+    sync_spawns();
+}
+
+SpawnPool & Interpreter::spawn_pool()
+{
+    if (spawn_pool_ == nullptr)
+    {
+        size_t stack_size = max_depth_ * native_stack_per_call + 2 * native_stack_reserve;
+        own_spawn_pool_.reset(new SpawnPool(spawn_threads_, stack_size, [this](SpawnPool & pool, size_t queue)
+        {
+            work(pool, queue);
+        }));
+        spawn_pool_ = own_spawn_pool_.get();
+    }
+
+    return *spawn_pool_;
+}
+
+/*
+ * body of a worker thread, the context of its tasks is an interpreter of its own
+ */
+void Interpreter::work(SpawnPool & pool, size_t queue)
+{
+    Interpreter context(output_, input_);
+    context.max_depth_ = max_depth_;
+    context.tail_calls_ = tail_calls_;
+    context.spawn_pool_ = &pool;
+    context.spawn_queue_ = queue;
+    context.start();
+    context.define_functions(root_);
+
+    while (SpawnTask * task = pool.take_or_wait(queue))
+    {
+        context.run_task(*task);
+    }
+}
+
+/*
+ * the task may be run nested in whatever the context is running,
+ * which goes on after it, so the state is restored even if it fails
+ */
+void Interpreter::run_task(SpawnTask & task)
+{
+    size_t frame_base = frame_base_;
+    size_t depth = depth_;
+    size_t spawns_base = spawns_base_;
+    size_t spawns = spawns_.size();
+    size_t memo_args = memo_args_.size();
+    FunctionCallNode const * tail_call = tail_call_;
+    Value last_value = last_value_;
+    bool was_return = was_return_;
+    size_t base = 0;
+    bool pushed = false;
+
+    try
+    {
+        FunctionDefinition * function = functions_[task.function->get_index()].get();
+
+        char native_stack_marker;
+        if (task.depth >= max_depth_ || &native_stack_marker < native_stack_limit_)
+        {
+            throw InterpreterRuntimeException(task.line, "maximum call depth exceeded");
+        }
+
+        base = frames_.push_frame(function->get_slots_num());
+        pushed = true;
+        for (size_t i = 0; i < task.args.size(); i++)
+        {
+            frames_.set_var_value(base, i, task.args[i]);
+        }
+
+        depth_ = task.depth + 1;
+        tail_call_ = nullptr;
+        was_return_ = false;
+        run_function(function, base);
+        task.result = last_value_;
+    }
+    catch (...)
+    {
+        task.error = std::current_exception();
+        //the depth the error left is of no call anymore
+        depth_ = task.depth + 1;
+        abandon_spawns(spawns);
+        memo_args_.resize(memo_args);
+
+        if (pushed)
+        {
+            frames_.pop_frame(base);
+        }
+    }
+
+    frame_base_ = frame_base;
+    depth_ = depth;
+    spawns_base_ = spawns_base;
+    tail_call_ = tail_call;
+    last_value_ = std::move(last_value);
+    was_return_ = was_return;
+    task.done = true;
+}
+
+/*
+ * runs other tasks while the task is being run elsewhere, only those
+ * spawned as deep as the current call, so the stack stays within max depth
+ */
+void Interpreter::wait_for(SpawnTask & task)
+{
+    while (!task.done)
+    {
+        SpawnTask * other = spawn_pool_->take(spawn_queue_, depth_);
+
+        if (other != nullptr)
+        {
+            run_task(*other);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
     }
 }
 
+/*
+ * the first error in the order of the spawns is thrown
+ */
+void Interpreter::sync_spawns()
+{
+    for (size_t i = spawns_base_; i < spawns_.size(); i++)
+    {
+        wait_for(*spawns_[i].task);
+    }
+
+    std::exception_ptr error;
+    for (size_t i = spawns_base_; i < spawns_.size() && error == nullptr; i++)
+    {
+        SpawnTask const & task = *spawns_[i].task;
+        error = task.error;
+        frames_.set_var_value(frame_base_, spawns_[i].slot, task.result);
+    }
+
+    spawns_.erase(spawns_.begin() + spawns_base_, spawns_.end());
+
+    if (error != nullptr)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+/*
+ * joins the tasks of calls left by an error, they may be running elsewhere
+ */
+void Interpreter::abandon_spawns(size_t first)
+{
+    for (size_t i = first; i < spawns_.size(); i++)
+    {
+        wait_for(*spawns_[i].task);
+    }
+
+    spawns_.erase(spawns_.begin() + first, spawns_.end());
+}
+
+void Interpreter::report_memoization(std::ostream & os) const
+{
+    std::vector<std::pair<std::string, MemoCache const *>> memos;
+    for (auto const & memo : memos_)
+    {
+        memos.push_back(std::make_pair(memo.first.str(), &memo.second));
+    }
+    std::sort(memos.begin(), memos.end());
+
+    os << "memoization: " << memos.size() << " pure functions, at most "
+       << MemoCache::max_entries << " results cached per function" << std::endl;
+    os << std::left << std::setw(30) << "function" << std::right << std::setw(14) << "calls"
+       << std::setw(14) << "hits" << std::setw(10) << "hit %" << std::setw(10) << "cached" << std::endl;
+
+    for (auto const & memo : memos)
+    {
+        size_t calls = memo.second->get_hits() + memo.second->get_misses();
+        double hit_rate = calls == 0 ? 0 : 100.0 * memo.second->get_hits() / calls;
+
+        os << std::left << std::setw(30) << memo.first << std::right << std::setw(14) << calls
+           << std::setw(14) << memo.second->get_hits() << std::setw(10) << std::fixed << std::setprecision(1)
+           << hit_rate << std::setw(10) << memo.second->get_size() << std::endl;
+    }
+}
@@ -1,11 +1,20 @@
+#include <iostream>
 #include <string>
-#include <map>
+#include <unordered_map>
 #include <memory>
 #include <vector>
+#include <exception>
 #include "pp.h"
 #include "ast.h"
 #include "ast_visitor.h"
+#include "value.h"
 #include "context.h"
+#include "output.h"
+#include "input.h"
+#include "native_stack.h"
+#include "memo_cache.h"
+#include "jit.h"
+#include "spawn_pool.h"
 
 #ifndef INTERPRETER_H
 #define INTERPRETER_H
@@ -13,19 +22,33 @@
 class FunctionDefinition
 {
     public:
-       FunctionDefinition(std::string name, std::vector<std::string> params, StatementsSequence const & statements) :
+       FunctionDefinition(StringRef name, NamesSequence params, StatementsSequence const & statements, size_t slots_num) :
            name_(name),
            params_(params),
-           statements_(statements) {}
+           statements_(statements),
+           slots_num_(slots_num),
+           memo_(nullptr) {}
 
-       std::string const & get_name() const { return name_; }
-       std::vector<std::string> const & get_params() const { return params_; }
+       StringRef get_name() const { return name_; }
+       NamesSequence const & get_params() const { return params_; }
        StatementsSequence const & get_statements() const { return statements_; } 
+       size_t get_slots_num() const { return slots_num_; }
+
+       /*
+        * cache of the results, nullptr unless the function is memoized
+        */
+       MemoCache * get_memo() const { return memo_; }
+       void set_memo(MemoCache * memo) { memo_ = memo; }
+
+       JitState & get_jit() { return jit_; }
 
     private:
-        std::string name_;
-        std::vector<std::string> params_;
+        StringRef name_;
+        NamesSequence params_;
         StatementsSequence const & statements_;
+        size_t slots_num_;
+        MemoCache * memo_;
+        JitState jit_;
 };
 
 typedef std::shared_ptr<FunctionDefinition> FunctionDefinitionPtr;
@@ -41,9 +64,86 @@ class InterpreterRuntimeException : public LineNumberException
 class Interpreter : public ASTNodeVisitor 
 {
     public:
-        Interpreter() : was_return_(false) {}
+        static const size_t default_max_depth = 1000000;
+        //native stack left to unwind and report the overflow
+        static const size_t native_stack_reserve = 256 * 1024;
+        //upper bound of native stack a call takes with modest expressions
+        static const size_t native_stack_per_call = 1024;
+
+        Interpreter(OutputBuffer & output, InputReader & input) :
+            output_(output),
+            input_(input),
+            frame_base_(0),
+            depth_(0),
+            max_depth_(default_max_depth),
+            native_stack_limit_(nullptr),
+            tail_call_(nullptr),
+            tail_calls_(true),
+            memoize_(false),
+            jit_enabled_(false),
+            jit_log_(nullptr),
+            jit_failed_(false),
+            jit_overflow_(false),
+            was_return_(false),
+            root_(nullptr),
+            spawn_threads_(0),
+            spawns_base_(0),
+            spawn_pool_(nullptr),
+            spawn_queue_(0)
+        {}
+
+        virtual ~Interpreter() {}
+
+        /*
+         * deeper calls fail with a runtime error, as do calls
+         * that would exhaust the native stack
+         */
+        void set_max_depth(size_t max_depth) { max_depth_ = max_depth; }
+
+        /*
+         * caches results of the functions PurityAnalyzer marked as pure
+         */
+        void set_memoize(bool memoize) { memoize_ = memoize; }
+
+        /*
+         * compiles functions to native code once they are called JitCompiler::threshold times,
+         * log gets what was compiled and what was left to the interpreter
+         */
+        void set_jit(bool enabled, std::ostream * log)
+        {
+            jit_enabled_ = enabled;
+            jit_log_ = log;
+        }
+
+        /*
+         * threads running spawned calls besides the one executing the program,
+         * with none the calls run when they are synced
+         */
+        void set_spawn_threads(size_t threads) { spawn_threads_ = threads; }
+
+        virtual void execute(ASTNodePtr root);
 
-        void execute(ASTNodePtr root);
+        /*
+         * --stream runs top-level statements as they come: begin() with the root
+         * holding the definitions and the global slots, then every statement
+         * until one returns false, as a return at the top level stops the program
+         */
+        void begin(RootNode * root);
+        bool execute_statement(ASTNodePtr statement);
+        void end();
+
+        /*
+         * hit rates of the caches of the last execution
+         */
+        void report_memoization(std::ostream & os) const;
+
+        /*
+         * the definition the call is bound to by Linker
+         */
+        FunctionDefinition * get_function(FunctionCallNode const * node) const
+        {
+            return functions_[node->get_target()->get_index()].get();
+        }
 
         virtual void visit(RootNode * node) override;
         virtual void visit(FunctionDefinitionNode * node) override;
@@ -59,49 +159,224 @@ class Interpreter : public ASTNodeVisitor
         virtual void visit(UnaryMinusNode * node) override;
         virtual void visit(BinaryOperatorNode * node) override;
 
+        //fast paths of specialized kinds
+        virtual void visit(VariableLiteralOperatorNode * node) override;
+        virtual void visit(VariablesOperatorNode * node) override;
+        virtual void visit(CompareIfNode * node) override;
+        virtual void visit(CompareWhileNode * node) override;
+        virtual void visit(IncrementNode * node) override;
+
+        virtual void visit(SpawnNode * node) override;
+        virtual void visit(SyncNode * node) override;
+
+    protected:
+        /*
+         * number of function calls being executed
+         */
+        size_t get_depth() const { return depth_; }
+
+        /*
+         * return f(...) reuses the frame of the returning function,
+         * so the call isn't visited on its own
+         */
+        bool is_tail_call(ReturnNode const * node) const { return tail_calls_ && node->is_tail_call(); }
+        void set_tail_calls(bool enabled) { tail_calls_ = enabled; }
+
+        /*
+         * whether the variable is read from the current frame, not from globals
+         */
+        bool is_local_read(VariableNode const * node) const
+        {
+            return node->get_slot() != no_slot && frames_.isset_variable(frame_base_, node->get_slot());
+        }
+
     private:
         void throw_error(std::string const & msg, ASTNode const * in_node)
         {
             throw InterpreterRuntimeException(in_node->get_line_num(), msg);
         }
 
-        void assert_runtime_error(bool condition, std::string const & msg, ASTNode const * in_node) 
+        /*
+         * takes a plain message, so nothing is built on the hot path
+         */
+        void assert_runtime_error(bool condition, char const * msg, ASTNode const * in_node) 
         {
             if (!condition) {
                 throw_error(msg, in_node);
             }
         }
 
-        pp_value_t value_of(ASTNodePtr node) 
+        Value value_of(ASTNodePtr node) 
         {
             node->accept(this);
-            return last_value_;
+            return std::move(last_value_);
+        }
+
+        /*
+         * local if it's set, global otherwise
+         */
+        Value const & variable_value(VariableNode const * node)
+        {
+            if (is_local_read(node))
+            {
+                return frames_.get_var_value(frame_base_, node->get_slot());
+            }
+
+            return global_value(node);
+        }
+
+        Value const & global_value(VariableNode const * node);
+
+        PP_ALWAYS_INLINE Value apply(BinaryOperatorNode const * node, Value const & first_operand, Value const & second_operand)
+        {
+            switch (node->get_type()) 
+            {
+                case BinaryOperatorType::PLUS:
+                    return first_operand + second_operand;
+                case BinaryOperatorType::MINUS:
+                    return first_operand - second_operand;
+                case BinaryOperatorType::MULTIPLY:
+                    return first_operand * second_operand;
+                case BinaryOperatorType::DIVIDE:
+                    assert_runtime_error(
+                        !second_operand.is_zero(), 
+                        "division by zero", 
+                        node
+                    );
+
+                    return first_operand / second_operand;
+                default:
+                    return compare(node, first_operand, second_operand);
+            }
+        }
+
+        /*
+         * comparisons are tested without making a value of the result
+         */
+        PP_ALWAYS_INLINE bool compare(BinaryOperatorNode const * node, Value const & first_operand, Value const & second_operand)
+        {
+            switch (node->get_type()) 
+            {
+                case BinaryOperatorType::EQUALS:
+                    return first_operand == second_operand;
+                case BinaryOperatorType::NOT_EQUALS:
+                    return first_operand != second_operand;
+                case BinaryOperatorType::LESS:
+                    return first_operand < second_operand;
+                case BinaryOperatorType::LESS_OR_EQALS:
+                    return first_operand <= second_operand;
+                case BinaryOperatorType::MORE:
+                    return first_operand > second_operand;
+                case BinaryOperatorType::MORE_OR_EQUALS:
+                    return first_operand >= second_operand;
+                default:
+                    throw_error("unknown operator type", node);
+            }
+
+            return false;
         }
 
+        bool is_true(BinaryOperatorNode * condition, OperandsKind operands_kind);
+
+        void start();
+        void define_functions(RootNode * node);
+
         void clear() 
         {
-            root_context_.reset();
-            contexts_stack_.clear();
+            frames_.clear();
+            frame_base_ = 0;
+            depth_ = 0;
+            tail_call_ = nullptr;
             functions_.clear();
+            memo_args_.clear();
+            jit_.reset();
+            jit_failed_ = false;
+            jit_overflow_ = false;
+            spawns_.clear();
+            spawns_base_ = 0;
+            own_spawn_pool_.reset();
+            spawn_pool_ = nullptr;
         }
 
-        ContextPtr current_context() 
+        FunctionDefinition & find_function(FunctionCallNode const * node)
         {
-            return contexts_stack_.back(); 
+            return *functions_[node->get_target()->get_index()];
         }
 
-        void execute_sequence(StatementsSequence const & sequence, bool within_function);
-        void execute_sequence(StatementsSequence const & sequence) 
+        size_t push_arguments(FunctionCallNode const * node, FunctionDefinition const & function);
+        void run_function(FunctionDefinition * function, size_t callee_base);
+
+        bool is_compiled(FunctionDefinition * function);
+        bool run_compiled(FunctionDefinition * function, size_t base);
+        static pp_value_t jit_interpret(pp_value_t const * args, FunctionDefinition * function, Interpreter * self);
+        static void jit_fail(Interpreter * self, char const * msg, size_t line);
+
+        /*
+         * spawned calls wait in the pool, the spawning function assigns their
+         * results when it syncs, in the order they were spawned
+         */
+        struct PendingSpawn
+        {
+            int slot;
+            std::unique_ptr<SpawnTask> task;
+        };
+
+        SpawnPool & spawn_pool();
+        void work(SpawnPool & pool, size_t queue);
+        void run_task(SpawnTask & task);
+        void wait_for(SpawnTask & task);
+        void sync_spawns();
+        void abandon_spawns(size_t first);
+
+        bool execute_sequence(StatementsSequence const & sequence, bool within_function);
+        bool execute_sequence(StatementsSequence const & sequence) 
         {
-            execute_sequence(sequence, false);
+            return execute_sequence(sequence, false);
         }
 
-        ContextPtr root_context_;
-        std::vector<ContextPtr> contexts_stack_;
-        std::map<std::string, FunctionDefinitionPtr> functions_;
+        OutputBuffer & output_;
+        InputReader & input_;
+
+        //globals are the bottom frame, at base 0
+        FrameStack frames_;
+        size_t frame_base_;
+        size_t depth_;
+        size_t max_depth_;
+        char const * native_stack_limit_;
+        //call to make in place of the function being left
+        FunctionCallNode const * tail_call_;
+        bool tail_calls_;
+        //by the index of the definition
+        std::vector<FunctionDefinitionPtr> functions_;
+        bool memoize_;
+        std::unordered_map<StringRef, MemoCache, StringRefHash> memos_;
+        //arguments of the memoized calls being executed, the body may reassign parameters
+        std::vector<Value> memo_args_;
+        bool jit_enabled_;
+        std::ostream * jit_log_;
+        std::unique_ptr<JitCompiler> jit_;
+        //set by compiled code when the interpreter or a check failed, the error waits in jit_exception_
+        bool jit_failed_;
+        std::exception_ptr jit_exception_;
+        //the failure was a value compiled code can't hold, the call is made again by the interpreter
+        bool jit_overflow_;
+        //arguments of compiled calls, stacked as the calls nest
+        std::vector<pp_value_t> jit_args_;
         
-        pp_value_t last_value_;
+        Value last_value_;
         bool was_return_;
+
+        //workers define the functions of the program on their own
+        RootNode * root_;
+        size_t spawn_threads_;
+        std::vector<PendingSpawn> spawns_;
+        //first spawn of the function being executed
+        size_t spawns_base_;
+        //of the context whose program it is, workers share it
+        SpawnPool * spawn_pool_;
+        size_t spawn_queue_;
+        //last, so the workers are joined before the rest is destroyed
+        std::unique_ptr<SpawnPool> own_spawn_pool_;
 };
 
 #endif //INTERPRETER_H
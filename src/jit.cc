@@ -0,0 +1,523 @@
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "jit.h"
+#include "interpreter.h"
+#include "compiler.h"
+
+//registers as encoded in ModRM
+static const uint8_t rax = 0;
+static const uint8_t rcx = 1;
+static const uint8_t rdi = 7;
+
+//second opcode bytes of setcc and 0x0f-prefixed jcc
+static const uint8_t jo = 0x80;
+static const uint8_t jz = 0x84;
+static const uint8_t jne = 0x85;
+static const uint8_t jb = 0x82;
+static const uint8_t jae = 0x83;
+static const uint8_t jle = 0x8e;
+
+char const JitCompiler::overflow[] = "integer overflow";
+
+template<class T>
+static T * node_cast(ASTNodePtr const & node)
+{
+    return dynamic_cast<T *>(&*node);
+}
+
+JitCompiler::~JitCompiler()
+{
+    for (auto const & page : pages_)
+    {
+        munmap(page.first, page.second);
+    }
+}
+
+bool JitCompiler::compile(FunctionDefinition * function)
+{
+    VariablesAnalyzer analyzer;
+    analyzer.analyze(function->get_statements(), function->get_params());
+
+    function_ = function;
+    analyzer_ = &analyzer;
+    rejected_.clear();
+    code_.clear();
+    returns_.clear();
+    bails_.clear();
+    failures_.clear();
+    frame_size_ = 8 * function->get_slots_num();
+    max_frame_size_ = frame_size_;
+
+    //push rbp; mov rbp, rsp; sub rsp, frame size
+    emit({0x55, 0x48, 0x89, 0xe5, 0x48, 0x81, 0xec});
+    size_t frame_size_position = code_.size();
+    emit32(0);
+
+    //mov rax, [rdi + 8 * i]; mov [rbp + slot], rax
+    for (size_t i = 0; i < function->get_params().size(); i++)
+    {
+        emit({0x48, 0x8b, 0x87});
+        emit32(8 * i);
+        emit_rbp(0x89, rax, slot_offset(i));
+    }
+
+    body_start_ = code_.size();
+    compile_sequence(function->get_statements());
+
+    if (!rejected_.empty())
+    {
+        if (log_ != nullptr)
+        {
+            *log_ << "jit: " << function->get_name().str() << " is left to the interpreter, " << rejected_ << std::endl;
+        }
+        return false;
+    }
+
+    //no return statement, xor eax, eax
+    emit({0x31, 0xc0});
+
+    //leave; ret
+    size_t epilogue = code_.size();
+    emit({0xc9, 0xc3});
+
+    for (size_t position : returns_)
+    {
+        patch_jump(position, epilogue);
+    }
+    for (size_t position : bails_)
+    {
+        patch_jump(position, epilogue);
+    }
+
+    //errors are reported by the interpreter, the code returns right after
+    for (Failure const & failure : failures_)
+    {
+        patch_jump(failure.position, code_.size());
+        emit_pointer(0xbf, runtime_.interpreter);
+        emit_pointer(0xbe, failure.msg);
+        emit_pointer(0xba, reinterpret_cast<void const *>(failure.line));
+        emit_pointer(0xb8, reinterpret_cast<void const *>(runtime_.fail));
+        emit({0xff, 0xd0});
+        patch_jump(emit_jump({0xe9}), epilogue);
+    }
+
+    //calls are made with rsp aligned to 16 bytes
+    int32_t frame_size = (max_frame_size_ + 15) & ~static_cast<size_t>(15);
+    std::memcpy(&code_[frame_size_position], &frame_size, sizeof(frame_size));
+
+    void * code = install();
+    if (code == nullptr)
+    {
+        return false;
+    }
+
+    function->get_jit().entry = reinterpret_cast<JitEntry>(code);
+    function->get_jit().compiled = true;
+
+    if (log_ != nullptr)
+    {
+        *log_ << "jit: compiled " << function->get_name().str() << " after " << function->get_jit().calls
+              << " calls, " << code_.size() << " bytes" << std::endl;
+    }
+
+    return true;
+}
+
+void * JitCompiler::install()
+{
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t size = (code_.size() + page_size - 1) / page_size * page_size;
+
+    void * pages = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pages == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    std::memcpy(pages, code_.data(), code_.size());
+
+    //never writable and executable at once
+    if (mprotect(pages, size, PROT_READ | PROT_EXEC) != 0)
+    {
+        munmap(pages, size);
+        return nullptr;
+    }
+
+    pages_.push_back(std::make_pair(pages, size));
+    return pages;
+}
+
+void JitCompiler::reject(std::string const & reason, ASTNode const * node)
+{
+    if (rejected_.empty())
+    {
+        rejected_ = reason + " at line " + std::to_string(node->get_line_num());
+    }
+}
+
+void JitCompiler::emit32(int32_t value)
+{
+    uint8_t bytes[sizeof(value)];
+    std::memcpy(bytes, &value, sizeof(value));
+    code_.insert(code_.end(), bytes, bytes + sizeof(value));
+}
+
+void JitCompiler::emit64(uint64_t value)
+{
+    uint8_t bytes[sizeof(value)];
+    std::memcpy(bytes, &value, sizeof(value));
+    code_.insert(code_.end(), bytes, bytes + sizeof(value));
+}
+
+/*
+ * mov r64, imm64
+ */
+void JitCompiler::emit_pointer(uint8_t opcode, void const * pointer)
+{
+    emit({0x48, opcode});
+    emit64(reinterpret_cast<uint64_t>(pointer));
+}
+
+/*
+ * 64-bit instruction with [rbp + disp32] operand
+ */
+void JitCompiler::emit_rbp(uint8_t opcode, uint8_t reg, int32_t offset)
+{
+    emit({0x48, opcode, static_cast<uint8_t>(0x85 | reg << 3)});
+    emit32(offset);
+}
+
+/*
+ * returns position of rel32 to patch
+ */
+size_t JitCompiler::emit_jump(std::initializer_list<uint8_t> opcode)
+{
+    emit(opcode);
+    size_t position = code_.size();
+    emit32(0);
+
+    return position;
+}
+
+void JitCompiler::patch_jump(size_t position, size_t target)
+{
+    int32_t offset = static_cast<int32_t>(target) - static_cast<int32_t>(position + 4);
+    std::memcpy(&code_[position], &offset, sizeof(offset));
+}
+
+void JitCompiler::emit_fail_jump(std::initializer_list<uint8_t> opcode, char const * msg, ASTNode const * node)
+{
+    failures_.push_back(Failure{emit_jump(opcode), msg, node->get_line_num()});
+}
+
+/*
+ * returns rbp offset of a block of the frame, released by restoring frame_size_
+ */
+int32_t JitCompiler::alloc(size_t bytes)
+{
+    frame_size_ += (bytes + 7) / 8 * 8;
+    if (frame_size_ > max_frame_size_)
+    {
+        max_frame_size_ = frame_size_;
+    }
+
+    return -static_cast<int32_t>(frame_size_);
+}
+
+void JitCompiler::compile_sequence(StatementsSequence const & statements)
+{
+    for (ASTNodePtr const & statement : statements)
+    {
+        statement->accept(this);
+    }
+}
+
+void JitCompiler::visit(RootNode * node)
+{
+    reject("program", node);
+}
+
+void JitCompiler::visit(FunctionDefinitionNode * node)
+{
+    reject("function definition", node);
+}
+
+void JitCompiler::visit(AssignmentNode * node)
+{
+    node->get_expr()->accept(this);
+    emit_rbp(0x89, rax, slot_offset(node->get_slot()));
+}
+
+void JitCompiler::visit(FunctionCallNode * node)
+{
+    compile_call(node, false);
+}
+
+/*
+ * The depth is checked before the arguments are evaluated, as the interpreter does.
+ * The callee gets arguments in a block of the frame, its value comes in rax.
+ * A callee that overflows is interpreted, so the call may be made twice
+ */
+void JitCompiler::compile_call(FunctionCallNode * node, bool self_tail_call)
+{
+    FunctionDefinition * callee = runtime_.interpreter->get_function(node);
+
+    if (!node->get_target()->is_pure())
+    {
+        reject("call of " + node->get_name().str() + " which isn't pure", node);
+        return;
+    }
+
+    if (!self_tail_call)
+    {
+        //mov rax, &depth; mov rax, [rax]; mov rcx, max_depth; cmp rax, rcx; jae fail
+        emit_pointer(0xb8, runtime_.depth);
+        emit({0x48, 0x8b, 0x00});
+        emit_pointer(0xb9, reinterpret_cast<void const *>(runtime_.max_depth));
+        emit({0x48, 0x39, 0xc8});
+        emit_fail_jump({0x0f, jae}, "maximum call depth exceeded", node);
+
+        //mov rax, native stack limit; cmp rsp, rax; jb fail
+        emit_pointer(0xb8, runtime_.native_stack_limit);
+        emit({0x48, 0x39, 0xc4});
+        emit_fail_jump({0x0f, jb}, "maximum call depth exceeded", node);
+    }
+
+    size_t mark = frame_size_;
+    size_t params_num = node->get_params().size();
+    int32_t args = alloc(8 * params_num);
+
+    for (size_t i = 0; i < params_num; i++)
+    {
+        node->get_params()[i]->accept(this);
+        emit_rbp(0x89, rax, args + 8 * i);
+    }
+
+    if (self_tail_call)
+    {
+        //the arguments become parameters and the body starts over
+        for (size_t i = 0; i < params_num; i++)
+        {
+            emit_rbp(0x8b, rax, args + 8 * i);
+            emit_rbp(0x89, rax, slot_offset(i));
+        }
+
+        patch_jump(emit_jump({0xe9}), body_start_);
+        frame_size_ = mark;
+        return;
+    }
+
+    //mov rax, &depth; inc qword [rax]
+    emit_pointer(0xb8, runtime_.depth);
+    emit({0x48, 0xff, 0x00});
+
+    //lea rdi, [rbp + args]; mov rsi, callee; mov rdx, interpreter; mov rax, &entry; call [rax]
+    emit_rbp(0x8d, rdi, args);
+    emit_pointer(0xbe, callee);
+    emit_pointer(0xba, runtime_.interpreter);
+    emit_pointer(0xb8, &callee->get_jit().entry);
+    emit({0xff, 0x10});
+
+    //mov rcx, &depth; dec qword [rcx]
+    emit_pointer(0xb9, runtime_.depth);
+    emit({0x48, 0xff, 0x09});
+
+    //mov rcx, &failed; cmp byte [rcx], 0; jne epilogue
+    emit_pointer(0xb9, runtime_.failed);
+    emit({0x80, 0x39, 0x00});
+    bails_.push_back(emit_jump({0x0f, jne}));
+
+    frame_size_ = mark;
+}
+
+void JitCompiler::visit(IfStatementNode * node)
+{
+    //test rax, rax; jle end
+    node->get_expr()->accept(this);
+    emit({0x48, 0x85, 0xc0});
+    size_t end = emit_jump({0x0f, jle});
+
+    compile_sequence(node->get_statements());
+    patch_jump(end, code_.size());
+}
+
+void JitCompiler::visit(WhileStatementNode * node)
+{
+    size_t start = code_.size();
+
+    node->get_expr()->accept(this);
+    emit({0x48, 0x85, 0xc0});
+    size_t end = emit_jump({0x0f, jle});
+
+    compile_sequence(node->get_statements());
+    patch_jump(emit_jump({0xe9}), start);
+    patch_jump(end, code_.size());
+}
+
+void JitCompiler::visit(PrintNode * node)
+{
+    reject("print", node);
+}
+
+void JitCompiler::visit(ReadNode * node)
+{
+    reject("read", node);
+}
+
+void JitCompiler::visit(SpawnNode * node)
+{
+    reject("spawn", node);
+}
+
+void JitCompiler::visit(SyncNode * node)
+{
+    reject("sync", node);
+}
+
+void JitCompiler::visit(ReturnNode * node)
+{
+    if (node->is_tail_call())
+    {
+        FunctionCallNode * call = static_cast<FunctionCallNode *>(node->get_expr());
+
+        //the interpreter doesn't count tail calls in the depth, only a jump does the same
+        if (runtime_.interpreter->get_function(call) != function_)
+        {
+            reject("tail call of another function", node);
+            return;
+        }
+
+        compile_call(call, true);
+        return;
+    }
+
+    node->get_expr()->accept(this);
+    returns_.push_back(emit_jump({0xe9}));
+}
+
+void JitCompiler::visit(VariableNode * node)
+{
+    if (node->get_slot() == no_slot || analyzer_->is_checked_read(node))
+    {
+        reject("read of " + node->get_var_name() + " which may be global", node);
+        return;
+    }
+
+    //mov rax, [rbp + slot]
+    emit_rbp(0x8b, rax, slot_offset(node->get_slot()));
+}
+
+void JitCompiler::visit(LiteralNode * node)
+{
+    load_literal(rax, node->get_value());
+}
+
+void JitCompiler::visit(UnaryMinusNode * node)
+{
+    //neg rax; jo fail
+    node->get_expr()->accept(this);
+    emit({0x48, 0xf7, 0xd8});
+    emit_fail_jump({0x0f, jo}, overflow, node);
+}
+
+/*
+ * mov reg, imm32 sign-extended if the value fits, mov reg, imm64 otherwise
+ */
+void JitCompiler::load_literal(uint8_t reg, pp_value_t value)
+{
+    if (value >= INT32_MIN && value <= INT32_MAX)
+    {
+        emit({0x48, 0xc7, static_cast<uint8_t>(0xc0 | reg)});
+        emit32(static_cast<int32_t>(value));
+    }
+    else
+    {
+        emit({0x48, static_cast<uint8_t>(0xb8 | reg)});
+        emit64(static_cast<uint64_t>(value));
+    }
+}
+
+/*
+ * literals and locals are loaded right into rcx
+ */
+void JitCompiler::load_rcx(ASTNodePtr node)
+{
+    LiteralNode * literal = node_cast<LiteralNode>(node);
+    VariableNode * variable = node_cast<VariableNode>(node);
+
+    if (literal != nullptr)
+    {
+        load_literal(rcx, literal->get_value());
+    }
+    else if (variable != nullptr && variable->get_slot() != no_slot && !analyzer_->is_checked_read(variable))
+    {
+        emit_rbp(0x8b, rcx, slot_offset(variable->get_slot()));
+    }
+    else
+    {
+        //the first operand waits in the frame
+        size_t mark = frame_size_;
+        int32_t first = alloc(8);
+
+        emit_rbp(0x89, rax, first);
+        node->accept(this);
+        emit({0x48, 0x89, 0xc1});
+        emit_rbp(0x8b, rax, first);
+
+        frame_size_ = mark;
+    }
+}
+
+void JitCompiler::visit(BinaryOperatorNode * node)
+{
+    node->get_first_expr()->accept(this);
+    load_rcx(node->get_second_expr());
+
+    uint8_t setcc = 0;
+
+    switch (node->get_type())
+    {
+        case BinaryOperatorType::PLUS:
+            //add rax, rcx; jo fail
+            emit({0x48, 0x01, 0xc8});
+            emit_fail_jump({0x0f, jo}, overflow, node);
+            return;
+        case BinaryOperatorType::MINUS:
+            emit({0x48, 0x29, 0xc8});
+            emit_fail_jump({0x0f, jo}, overflow, node);
+            return;
+        case BinaryOperatorType::MULTIPLY:
+            emit({0x48, 0x0f, 0xaf, 0xc1});
+            emit_fail_jump({0x0f, jo}, overflow, node);
+            return;
+        case BinaryOperatorType::DIVIDE:
+        {
+            //test rcx, rcx; jz fail; cmp rcx, -1; jne divide
+            emit({0x48, 0x85, 0xc9});
+            emit_fail_jump({0x0f, jz}, "division by zero", node);
+            emit({0x48, 0x83, 0xf9, 0xff});
+            size_t divide = emit_jump({0x0f, jne});
+
+            //idiv traps on the minimum divided by -1, neg rax; jo fail; jmp end
+            emit({0x48, 0xf7, 0xd8});
+            emit_fail_jump({0x0f, jo}, overflow, node);
+            size_t end = emit_jump({0xe9});
+
+            //cqo; idiv rcx
+            patch_jump(divide, code_.size());
+            emit({0x48, 0x99, 0x48, 0xf7, 0xf9});
+            patch_jump(end, code_.size());
+            return;
+        }
+        case BinaryOperatorType::EQUALS:         setcc = 0x94; break;
+        case BinaryOperatorType::NOT_EQUALS:     setcc = 0x95; break;
+        case BinaryOperatorType::LESS:           setcc = 0x9c; break;
+        case BinaryOperatorType::LESS_OR_EQALS:  setcc = 0x9e; break;
+        case BinaryOperatorType::MORE:           setcc = 0x9f; break;
+        case BinaryOperatorType::MORE_OR_EQUALS: setcc = 0x9d; break;
+    }
+
+    //cmp rax, rcx; setcc al; movzx eax, al
+    emit({0x48, 0x39, 0xc8, 0x0f, setcc, 0xc0, 0x0f, 0xb6, 0xc0});
+}
@@ -0,0 +1,149 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <initializer_list>
+#include <cstdint>
+#include "pp.h"
+#include "ast.h"
+#include "ast_visitor.h"
+
+#ifndef JIT_H
+#define JIT_H
+
+class Interpreter;
+class FunctionDefinition;
+class VariablesAnalyzer;
+
+/*
+ * Calling convention of compiled functions and of the interpreter entry
+ * standing for the functions that aren't compiled, so every call site is the same
+ */
+typedef pp_value_t (*JitEntry)(pp_value_t const * args, FunctionDefinition * function, Interpreter * interpreter);
+
+/*
+ * JIT state of a function. Compiled code calls through entry,
+ * so call sites compiled earlier switch to the code once it's there
+ */
+struct JitState
+{
+    JitState() : entry(nullptr), compiled(false), rejected(false), calls(0) {}
+
+    JitEntry entry;
+    bool compiled;
+    bool rejected;
+    size_t calls;
+};
+
+/*
+ * What compiled code reaches of the interpreter, all of it stays put during execution.
+ * An error sets failed and returns up to the interpreter
+ */
+struct JitRuntime
+{
+    Interpreter * interpreter;
+    size_t * depth;
+    size_t max_depth;
+    char const * native_stack_limit;
+    bool * failed;
+    void (*fail)(Interpreter * interpreter, char const * msg, size_t line);
+};
+
+/*
+ * Template JIT translating function bodies to x86-64 code in mmap'd pages.
+ * Values live in the native frame, every expression is computed into rax.
+ * Covers integer arithmetic, comparisons, if, while, assignments, calls
+ * and return, including self tail calls which become jumps. Functions that
+ * print, read, touch globals, may read unset variables, tail call another
+ * function or call one that isn't pure are left to the interpreter.
+ * Compiled code holds machine integers only, arithmetic that overflows
+ * fails with the overflow message and the interpreter takes the call over
+ */
+class JitCompiler : public ASTNodeVisitor
+{
+    public:
+        static const size_t threshold = 1000;
+        static char const overflow[];
+
+        JitCompiler(JitRuntime const & runtime, std::ostream * log) :
+            runtime_(runtime),
+            log_(log),
+            function_(nullptr),
+            analyzer_(nullptr),
+            frame_size_(0),
+            max_frame_size_(0)
+        {}
+
+        ~JitCompiler();
+
+        /*
+         * returns false if the function can't be compiled
+         */
+        bool compile(FunctionDefinition * function);
+
+        virtual void visit(RootNode * node) override;
+        virtual void visit(FunctionDefinitionNode * node) override;
+        virtual void visit(AssignmentNode * node) override;
+        virtual void visit(FunctionCallNode * node) override;
+        virtual void visit(IfStatementNode * node) override;
+        virtual void visit(WhileStatementNode * node) override;
+        virtual void visit(PrintNode * node) override;
+        virtual void visit(ReadNode * node) override;
+        virtual void visit(ReturnNode * node) override;
+        virtual void visit(VariableNode * node) override;
+        virtual void visit(LiteralNode * node) override;
+        virtual void visit(UnaryMinusNode * node) override;
+        virtual void visit(BinaryOperatorNode * node) override;
+
+        virtual void visit(SpawnNode * node) override;
+        virtual void visit(SyncNode * node) override;
+
+        JitCompiler &operator=(JitCompiler const &a) = delete;
+        JitCompiler(JitCompiler const &a) = delete;
+
+    private:
+        struct Failure
+        {
+            size_t position;
+            char const * msg;
+            size_t line;
+        };
+
+        void reject(std::string const & reason, ASTNode const * node);
+        void compile_sequence(StatementsSequence const & statements);
+        void compile_call(FunctionCallNode * node, bool self_tail_call);
+        void load_rcx(ASTNodePtr node);
+        void load_literal(uint8_t reg, pp_value_t value);
+
+        int32_t slot_offset(int slot) const { return -8 * (slot + 1); }
+        int32_t alloc(size_t bytes);
+
+        void emit(std::initializer_list<uint8_t> bytes) { code_.insert(code_.end(), bytes); }
+        void emit32(int32_t value);
+        void emit64(uint64_t value);
+        void emit_pointer(uint8_t opcode, void const * pointer);
+        void emit_rbp(uint8_t opcode, uint8_t reg, int32_t offset);
+
+        size_t emit_jump(std::initializer_list<uint8_t> opcode);
+        void patch_jump(size_t position, size_t target);
+        void emit_fail_jump(std::initializer_list<uint8_t> opcode, char const * msg, ASTNode const * node);
+
+        void * install();
+
+        JitRuntime runtime_;
+        std::ostream * log_;
+        std::vector<std::pair<void *, size_t>> pages_;
+
+        FunctionDefinition * function_;
+        VariablesAnalyzer const * analyzer_;
+        std::string rejected_;
+        std::vector<uint8_t> code_;
+        size_t body_start_;
+        std::vector<size_t> returns_;
+        std::vector<size_t> bails_;
+        std::vector<Failure> failures_;
+        size_t frame_size_;
+        size_t max_frame_size_;
+};
+
+#endif //JIT_H
@@ -1,36 +1,103 @@
 #include <cctype>
+#include <cstring>
 #include "lexer.h"
 
-std::vector< std::pair<std::string, LexemeType> > Lexer::sorted_key_tokens_;
+struct Keyword
+{
+    char const * word;
+    size_t length;
+    LexemeType type;
+};
+
+/*
+ * Perfect hash table of the keywords indexed by keyword_hash
+ */
+static const Keyword keywords_table[] = 
+{
+    {"def", 3, LexemeType::DEF},            //0
+    {"while", 5, LexemeType::WHILE},        //1
+    {nullptr, 0, LexemeType::IDENT},
+    {nullptr, 0, LexemeType::IDENT},
+    {nullptr, 0, LexemeType::IDENT},
+    {"if", 2, LexemeType::IF},              //5
+    {nullptr, 0, LexemeType::IDENT},
+    {nullptr, 0, LexemeType::IDENT},
+    {"print", 5, LexemeType::PRINT},        //8
+    {"sync", 4, LexemeType::SYNC},          //9
+    {"read", 4, LexemeType::READ},          //10
+    {nullptr, 0, LexemeType::IDENT},
+    {nullptr, 0, LexemeType::IDENT},
+    {"end", 3, LexemeType::END},            //13
+    {"return", 6, LexemeType::RETURN},      //14
+    {"spawn", 5, LexemeType::SPAWN}         //15
+};
+
+inline size_t keyword_hash(char const * ident, size_t length)
+{
+    return (static_cast<unsigned char>(ident[0]) + 2 * static_cast<unsigned char>(ident[length - 1])) & 15;
+}
 
-void Lexer::init_key_tokens() 
+LexemeType keyword_type(char const * ident, size_t length)
 {
-    sorted_key_tokens_ = std::vector< std::pair<std::string, LexemeType> >{
-            std::make_pair("=", LexemeType::ASSIGNMENT),
-            std::make_pair("+", LexemeType::PLUS),
-            std::make_pair("-", LexemeType::MINUS),
-            std::make_pair("*", LexemeType::MULTIPLY),
-            std::make_pair("/", LexemeType::DIVIDE),
-            std::make_pair("==", LexemeType::EQUALS),
-            std::make_pair("!=", LexemeType::NOT_EQUALS),
-            std::make_pair(">", LexemeType::MORE),
-            std::make_pair(">=", LexemeType::MORE_OR_EQUALS),
-            std::make_pair("<", LexemeType::LESS),
-            std::make_pair("<=", LexemeType::LESS_OR_EQALS),
-            std::make_pair("(", LexemeType::L_PARENTHESIS),
-            std::make_pair(")", LexemeType::R_PARENTHESIS),
-            std::make_pair("def", LexemeType::DEF),
-            std::make_pair("return", LexemeType::RETURN),
-            std::make_pair("end", LexemeType::END),
-            std::make_pair("if", LexemeType::IF),
-            std::make_pair("while", LexemeType::WHILE),
-            std::make_pair(":", LexemeType::COLON),
-            std::make_pair(",", LexemeType::COMMA),
-            std::make_pair("read", LexemeType::READ),
-            std::make_pair("print", LexemeType::PRINT)
-        };
-
-    std::sort(sorted_key_tokens_.begin(), sorted_key_tokens_.end(), std::greater<std::pair<std::string, LexemeType>>());
+    Keyword const & keyword = keywords_table[keyword_hash(ident, length)];
+
+    if (keyword.length == length && std::memcmp(keyword.word, ident, length) == 0)
+    {
+        return keyword.type;
+    }
+
+    return LexemeType::IDENT;
+}
+
+size_t match_operator(char const * begin, char const * end, LexemeType & type)
+{
+    bool has_next = begin + 1 != end;
+    bool followed_by_equals = has_next && begin[1] == '=';
+
+    switch (*begin)
+    {
+        case '+': type = LexemeType::PLUS;          return 1;
+        case '-': type = LexemeType::MINUS;         return 1;
+        case '*': type = LexemeType::MULTIPLY;      return 1;
+        case '/': type = LexemeType::DIVIDE;        return 1;
+        case '(': type = LexemeType::L_PARENTHESIS; return 1;
+        case ')': type = LexemeType::R_PARENTHESIS; return 1;
+        case ':': type = LexemeType::COLON;         return 1;
+        case ',': type = LexemeType::COMMA;         return 1;
+        case '=':
+            if (followed_by_equals)
+            {
+                type = LexemeType::EQUALS;
+                return 2;
+            }
+            type = LexemeType::ASSIGNMENT;
+            return 1;
+        case '!':
+            if (followed_by_equals)
+            {
+                type = LexemeType::NOT_EQUALS;
+                return 2;
+            }
+            return 0;
+        case '>':
+            if (followed_by_equals)
+            {
+                type = LexemeType::MORE_OR_EQUALS;
+                return 2;
+            }
+            type = LexemeType::MORE;
+            return 1;
+        case '<':
+            if (followed_by_equals)
+            {
+                type = LexemeType::LESS_OR_EQALS;
+                return 2;
+            }
+            type = LexemeType::LESS;
+            return 1;
+        default:
+            return 0;
+    }
 }
 
 void Lexer::read_next_chunk() 
@@ -80,18 +147,12 @@ bool Lexer::read_line()
  */
 void Lexer::greedy_match(char_matcher matcher, LexemeType type) 
 {
-    lexeme_value_ = "";
+    size_t start = chunk_position_;
     current_lexeme_ = type;
 
-    for (; chunk_position_ < current_chunk_.length() && matcher(current_chunk_[chunk_position_]); chunk_position_++)
-    {
-        lexeme_value_ += current_chunk_[chunk_position_];
-    }
-}
+    for (; chunk_position_ < current_chunk_.length() && matcher(current_chunk_[chunk_position_]); chunk_position_++);
 
-inline int isident(int c) 
-{
-    return isalnum(c) || c == '_';
+    lexeme_value_.assign(current_chunk_, start, chunk_position_ - start);
 }
 
 /*
@@ -122,25 +183,17 @@ bool Lexer::try_match_token()
     }
     
     char current_char = current_chunk_[chunk_position_];
-    
-    if (sorted_key_tokens_[0].first == ">=") {
-        return false;
-    }
+    size_t operator_length = match_operator(
+        &current_chunk_[chunk_position_], 
+        current_chunk_.data() + current_chunk_.length(),
+        current_lexeme_
+    );
 
-    for (const std::pair<std::string, LexemeType> & key_token : sorted_key_tokens_) 
+    if (operator_length != 0)
     {
-        std::string key = key_token.first;
-        if ((chunk_position_ + key.length() - 1) < current_chunk_.length()) 
-        {
-            if (current_chunk_.substr(chunk_position_, key.length()) == key) 
-            {
-                current_lexeme_ = key_token.second;
-                lexeme_value_ = key;
-
-                chunk_position_ += key.length();
-                return true;
-            }
-        }
+        lexeme_value_.assign(current_chunk_, chunk_position_, operator_length);
+        chunk_position_ += operator_length;
+        return true;
     }
 
     if (isdigit(current_char)) 
@@ -149,9 +202,10 @@ bool Lexer::try_match_token()
         return true;
     }
     
-    if (isident(current_char) && !isdigit(current_char)) 
+    if (isident(current_char)) 
     {
         greedy_match(isident, LexemeType::IDENT);
+        current_lexeme_ = keyword_type(lexeme_value_.data(), lexeme_value_.length());
         return true;
     }
     
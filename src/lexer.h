@@ -4,6 +4,7 @@
 #include <sstream>
 #include <utility>
 #include <algorithm>
+#include <cctype>
 #include "pp.h"
 #include "parser.h"
 
@@ -13,6 +14,22 @@
 const size_t chars_num = 256;
 const char comment_char = '#';
 
+inline int isident(int c) 
+{
+    return isalnum(c) || c == '_';
+}
+
+/*
+ * Keyword denoted by the whole identifier, IDENT if there's none
+ */
+LexemeType keyword_type(char const * ident, size_t length);
+
+/*
+ * Operator at the start of non-empty [begin, end), 
+ * returns its length or 0 if there's none
+ */
+size_t match_operator(char const * begin, char const * end, LexemeType & type);
+
 
 class Lexer : public IScanner 
 {
@@ -23,11 +40,7 @@ class Lexer : public IScanner
             eof_(false),
             was_new_line_(false),
             line_num_(0)
-        { 
-            if (sorted_key_tokens_.size() == 0) {
-                init_key_tokens();
-            }
-        }
+        {}
 
         virtual ~Lexer() {}
 
@@ -62,9 +75,6 @@ class Lexer : public IScanner
         bool eof_;
         bool was_new_line_;
         size_t line_num_;
-        
-        static void init_key_tokens();
-        static std::vector< std::pair<std::string, LexemeType> > sorted_key_tokens_; 
 };
 
 #endif
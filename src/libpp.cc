@@ -0,0 +1,176 @@
+#include <sstream>
+#include <exception>
+#include "libpp.h"
+#include "lexer.h"
+#include "parser.h"
+#include "optimizer.h"
+#include "resolver.h"
+#include "linker.h"
+#include "purity.h"
+#include "specializer.h"
+#include "interpreter.h"
+#include "output.h"
+#include "input.h"
+
+namespace pp
+{
+    /*
+     * Nothing changes the tree once it's compiled, every run
+     * has an interpreter with frames, caches and JIT code of its own
+     */
+    struct Program::Compiled
+    {
+        ProgramPtr program;
+    };
+
+    static Result error_result(Status status, LineNumberException const & e)
+    {
+        Result result;
+        result.status = status;
+        result.line = e.get_line_number();
+        result.message = e.what();
+        return result;
+    }
+
+    static Result internal_error(char const * msg)
+    {
+        Result result;
+        result.status = Status::INTERNAL_ERROR;
+        result.message = msg;
+        return result;
+    }
+
+    Result Program::compile(std::string const & source, Program & program, CompileOptions const & options) noexcept
+    {
+        try
+        {
+            std::istringstream source_stream(source);
+            Lexer lexer(source_stream);
+            Parser parser(lexer);
+            std::shared_ptr<Compiled> compiled(new Compiled());
+            compiled->program = parser.parse();
+
+            if (options.optimize)
+            {
+                Optimizer optimizer;
+                optimizer.optimize(compiled->program);
+            }
+
+            Resolver resolver;
+            resolver.resolve(compiled->program);
+            Linker linker;
+            linker.link(compiled->program);
+
+            //marks are used by memoize and spawned calls
+            PurityAnalyzer analyzer;
+            analyzer.analyze(compiled->program->get_root());
+
+            if (options.optimize)
+            {
+                Specializer specializer;
+                specializer.specialize(compiled->program);
+            }
+
+            program.compiled_ = compiled;
+            return Result();
+        }
+        catch (LinkException & e)
+        {
+            return error_result(Status::LINK_ERROR, e);
+        }
+        catch (LineNumberException & e)
+        {
+            return error_result(Status::SYNTAX_ERROR, e);
+        }
+        catch (std::exception & e)
+        {
+            return internal_error(e.what());
+        }
+        catch (...)
+        {
+            return internal_error("unknown error");
+        }
+    }
+
+    /*
+     * runtime errors come back, everything else is thrown
+     */
+    static Result execute(ASTNodePtr root, OutputBuffer & output, InputReader & input, RunOptions const & options)
+    {
+        Interpreter interpreter(output, input);
+        interpreter.set_max_depth(options.max_depth);
+        interpreter.set_memoize(options.memoize);
+        interpreter.set_jit(options.jit, nullptr);
+        interpreter.set_spawn_threads(options.spawn_threads);
+
+        try
+        {
+            interpreter.execute(root);
+        }
+        catch (LineNumberException & e)
+        {
+            return error_result(output.is_full() ? Status::OUTPUT_OVERFLOW : Status::RUNTIME_ERROR, e);
+        }
+
+        return Result();
+    }
+
+    Result Program::run(char const * input, size_t input_size,
+                        char * output, size_t output_capacity, size_t & output_size,
+                        RunOptions const & options) const noexcept
+    {
+        output_size = 0;
+
+        if (!compiled_)
+        {
+            return internal_error("program isn't compiled");
+        }
+
+        try
+        {
+            OutputBuffer output_buffer(output, output_capacity);
+            InputReader input_reader(input, input_size);
+            Result result = execute(compiled_->program->get_root(), output_buffer, input_reader, options);
+
+            output_size = output_buffer.get_size();
+            return result;
+        }
+        catch (std::exception & e)
+        {
+            return internal_error(e.what());
+        }
+        catch (...)
+        {
+            return internal_error("unknown error");
+        }
+    }
+
+    Result Program::run(char const * input, size_t input_size, std::string & output,
+                        RunOptions const & options) const noexcept
+    {
+        output.clear();
+
+        if (!compiled_)
+        {
+            return internal_error("program isn't compiled");
+        }
+
+        try
+        {
+            OutputBuffer output_buffer;
+            InputReader input_reader(input, input_size);
+            Result result = execute(compiled_->program->get_root(), output_buffer, input_reader, options);
+
+            output.assign(output_buffer.get_data(), output_buffer.get_size());
+            return result;
+        }
+        catch (std::exception & e)
+        {
+            return internal_error(e.what());
+        }
+        catch (...)
+        {
+            return internal_error("unknown error");
+        }
+    }
+}
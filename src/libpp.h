@@ -0,0 +1,92 @@
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#ifndef LIBPP_H
+#define LIBPP_H
+
+/*
+ * Embedding API of libpp.a and libpp.so. A program is compiled once into
+ * an immutable handle which may be run any number of times, from any number
+ * of threads at once. Nothing here throws, failures come back as a Result
+ */
+namespace pp
+{
+    enum class Status
+    {
+        OK, SYNTAX_ERROR, LINK_ERROR, RUNTIME_ERROR, OUTPUT_OVERFLOW, INTERNAL_ERROR
+    };
+
+    /*
+     * line is 0 for errors not tied to a line of the source
+     */
+    struct Result
+    {
+        Result() : status(Status::OK), line(0) {}
+
+        bool ok() const { return status == Status::OK; }
+
+        Status status;
+        size_t line;
+        std::string message;
+    };
+
+    struct CompileOptions
+    {
+        CompileOptions() : optimize(true) {}
+
+        //constant folding and specialized nodes, as -O1 of pp
+        bool optimize;
+    };
+
+    struct RunOptions
+    {
+        RunOptions() : max_depth(1000000), memoize(false), jit(false), spawn_threads(0) {}
+
+        //calls are also bounded by the stack of the calling thread
+        size_t max_depth;
+        bool memoize;
+        bool jit;
+        //threads of the run for spawned calls, with none they run on the calling thread
+        size_t spawn_threads;
+    };
+
+    class Program
+    {
+        public:
+            /*
+             * handle of no program, run fails on it
+             */
+            Program() {}
+
+            /*
+             * on failure program is left as it was
+             */
+            static Result compile(std::string const & source, Program & program,
+                                  CompileOptions const & options = CompileOptions()) noexcept;
+
+            /*
+             * read takes whitespace separated numbers from input, print writes lines into output.
+             * output_size is the number of bytes written; output that doesn't fit
+             * stops the program with OUTPUT_OVERFLOW, keeping the lines that fit
+             */
+            Result run(char const * input, size_t input_size,
+                       char * output, size_t output_capacity, size_t & output_size,
+                       RunOptions const & options = RunOptions()) const noexcept;
+
+            /*
+             * output grows as needed
+             */
+            Result run(char const * input, size_t input_size, std::string & output,
+                       RunOptions const & options = RunOptions()) const noexcept;
+
+            bool is_compiled() const { return compiled_ != nullptr; }
+
+        private:
+            struct Compiled;
+
+            std::shared_ptr<Compiled const> compiled_;
+    };
+}
+
+#endif //LIBPP_H
@@ -0,0 +1,162 @@
+#include <algorithm>
+#include "linker.h"
+
+void Linker::link(ProgramPtr program)
+{
+    RootNode * root = program->get_root();
+
+    link_functions(root);
+    visit_sequence(root->get_statements());
+    check();
+}
+
+void Linker::check()
+{
+    if (!errors_.empty())
+    {
+        //functions are visited before the statements between them
+        std::stable_sort(errors_.begin(), errors_.end(),
+            [](LinkException::Error const & a, LinkException::Error const & b) { return a.line < b.line; });
+
+        throw LinkException(errors_);
+    }
+}
+
+void Linker::link_functions(RootNode * root)
+{
+    StatementsSequence const & functions = root->get_functions();
+
+    for (size_t i = 0; i < functions.size(); i++)
+    {
+        FunctionDefinitionNode * function = static_cast<FunctionDefinitionNode *>(functions[i]);
+        function->set_index(i);
+        functions_[function->get_name()] = function;
+    }
+
+    collecting_ = false;
+    visit_sequence(functions);
+}
+
+void Linker::collect_calls(ASTNodePtr statement)
+{
+    collecting_ = true;
+    statement->accept(this);
+}
+
+bool Linker::can_bind_collected() const
+{
+    for (auto const & call : calls_)
+    {
+        auto it = functions_.find(StringRef(call.first.data(), call.first.size()));
+        if (it == functions_.end() || it->second->get_params().size() != call.second)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void Linker::link_statement(ASTNodePtr statement)
+{
+    collecting_ = false;
+    statement->accept(this);
+}
+
+void Linker::visit(RootNode * node)
+{
+    link_functions(node);
+    visit_sequence(node->get_statements());
+}
+
+void Linker::visit(FunctionDefinitionNode * node)
+{
+    visit_sequence(node->get_statements());
+}
+
+void Linker::visit_sequence(StatementsSequence const & statements)
+{
+    for (ASTNodePtr const & statement : statements)
+    {
+        statement->accept(this);
+    }
+}
+
+void Linker::visit(AssignmentNode * node)
+{
+    node->get_expr()->accept(this);
+}
+
+void Linker::visit(FunctionCallNode * node)
+{
+    for (ASTNodePtr const & param : node->get_params())
+    {
+        param->accept(this);
+    }
+
+    if (collecting_)
+    {
+        calls_.insert(std::make_pair(node->get_name().str(), node->get_params().size()));
+        return;
+    }
+
+    auto it = functions_.find(node->get_name());
+
+    if (it == functions_.end())
+    {
+        errors_.push_back(LinkException::Error{node->get_line_num(), "undefined function " + node->get_name()});
+    }
+    else if (it->second->get_params().size() != node->get_params().size())
+    {
+        errors_.push_back(LinkException::Error{node->get_line_num(), "arguments number mismatch for " + node->get_name()});
+    }
+    else
+    {
+        node->set_target(it->second);
+    }
+}
+
+void Linker::visit(IfStatementNode * node)
+{
+    node->get_expr()->accept(this);
+    visit_sequence(node->get_statements());
+}
+
+void Linker::visit(WhileStatementNode * node)
+{
+    node->get_expr()->accept(this);
+    visit_sequence(node->get_statements());
+}
+
+void Linker::visit(PrintNode * node)
+{
+    node->get_expr()->accept(this);
+}
+
+void Linker::visit(ReadNode *)
+{
+}
+
+void Linker::visit(ReturnNode * node)
+{
+    node->get_expr()->accept(this);
+}
+
+void Linker::visit(VariableNode *)
+{
+}
+
+void Linker::visit(LiteralNode *)
+{
+}
+
+void Linker::visit(UnaryMinusNode * node)
+{
+    node->get_expr()->accept(this);
+}
+
+void Linker::visit(BinaryOperatorNode * node)
+{
+    node->get_first_expr()->accept(this);
+    node->get_second_expr()->accept(this);
+}
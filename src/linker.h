@@ -0,0 +1,90 @@
+#include <string>
+#include <unordered_map>
+#include <set>
+#include <utility>
+#include <vector>
+#include "pp.h"
+#include "ast.h"
+#include "ast_visitor.h"
+#include "string_ref.h"
+
+#ifndef LINKER_H
+#define LINKER_H
+
+/*
+ * All the calls that can't be bound, in source order.
+ * The exception itself is the first one of them
+ */
+class LinkException : public LineNumberException
+{
+    public:
+        struct Error
+        {
+            size_t line;
+            std::string msg;
+        };
+
+        LinkException(std::vector<Error> const & errors) :
+            LineNumberException(errors.front().line, errors.front().msg),
+            errors_(errors)
+        {}
+
+        std::vector<Error> const & get_errors() const { return errors_; }
+
+    private:
+        std::vector<Error> errors_;
+};
+
+/*
+ * Binds every call to the definition of its function, the last one of the name,
+ * and numbers the definitions. Calls of undefined functions and calls with
+ * a wrong number of arguments are reported before anything is executed,
+ * whether they would be reached or not. Must be run after Resolver
+ */
+class Linker : public ASTNodeVisitor
+{
+    public:
+        Linker() : collecting_(false) {}
+
+        void link(ProgramPtr program);
+
+        /*
+         * --stream links the top level as it comes. Calls of the statements are
+         * collected before the definitions are known, if some of them can't be bound
+         * the statements are linked once more to report where, before execution
+         */
+        void collect_calls(ASTNodePtr statement);
+        void link_functions(RootNode * root);
+        bool can_bind_collected() const;
+        void link_statement(ASTNodePtr statement);
+
+        /*
+         * throws LinkException if there were calls that can't be bound
+         */
+        void check();
+
+        virtual void visit(RootNode * node) override;
+        virtual void visit(FunctionDefinitionNode * node) override;
+        virtual void visit(AssignmentNode * node) override;
+        virtual void visit(FunctionCallNode * node) override;
+        virtual void visit(IfStatementNode * node) override;
+        virtual void visit(WhileStatementNode * node) override;
+        virtual void visit(PrintNode * node) override;
+        virtual void visit(ReadNode * node) override;
+        virtual void visit(ReturnNode * node) override;
+        virtual void visit(VariableNode * node) override;
+        virtual void visit(LiteralNode * node) override;
+        virtual void visit(UnaryMinusNode * node) override;
+        virtual void visit(BinaryOperatorNode * node) override;
+
+    private:
+        void visit_sequence(StatementsSequence const & statements);
+
+        std::unordered_map<StringRef, FunctionDefinitionNode *, StringRefHash> functions_;
+        std::vector<LinkException::Error> errors_;
+        bool collecting_;
+        //names and numbers of arguments of the calls collected
+        std::set<std::pair<std::string, size_t>> calls_;
+};
+
+#endif //LINKER_H
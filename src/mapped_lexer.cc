@@ -0,0 +1,205 @@
+#include <cctype>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "mapped_lexer.h"
+#include "lexer.h"
+
+inline bool is_space(char c)
+{
+    return isspace(static_cast<unsigned char>(c));
+}
+
+inline bool is_digit(char c)
+{
+    return isdigit(static_cast<unsigned char>(c));
+}
+
+inline bool is_ident(char c)
+{
+    return isident(static_cast<unsigned char>(c));
+}
+
+MappedLexer::MappedLexer(std::string const & file_name) :
+    is_open_(false),
+    begin_(nullptr),
+    end_(nullptr),
+    mapped_size_(0),
+    current_lexeme_(LexemeType::UNDEFINED),
+    eof_(false),
+    was_new_line_(false),
+    line_num_(1)
+{
+    int fd = open(file_name.c_str(), O_RDONLY);
+
+    if (fd >= 0)
+    {
+        struct stat file_stat;
+
+        if (fstat(fd, &file_stat) == 0)
+        {
+            is_open_ = true;
+
+            if (file_stat.st_size > 0)
+            {
+                void * data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+                if (data == MAP_FAILED)
+                {
+                    is_open_ = false;
+                }
+                else
+                {
+                    madvise(data, file_stat.st_size, MADV_SEQUENTIAL);
+                    begin_ = static_cast<char const *>(data);
+                    mapped_size_ = file_stat.st_size;
+                }
+            }
+        }
+
+        close(fd);
+    }
+
+    end_ = begin_ + mapped_size_;
+    position_ = begin_;
+    chunk_end_ = begin_;
+}
+
+MappedLexer::MappedLexer(char const * begin, char const * end, size_t first_line) :
+    is_open_(true),
+    begin_(begin),
+    end_(end),
+    mapped_size_(0),
+    position_(begin),
+    chunk_end_(begin),
+    current_lexeme_(LexemeType::UNDEFINED),
+    eof_(false),
+    was_new_line_(false),
+    line_num_(first_line)
+{}
+
+MappedLexer::~MappedLexer()
+{
+    if (mapped_size_ != 0)
+    {
+        munmap(const_cast<char *>(begin_), mapped_size_);
+    }
+}
+
+/*
+ * Moves to the next whitespace separated chunk skipping comments,
+ * the rest of a line is a comment if a chunk starts with comment_char
+ */
+void MappedLexer::skip_to_next_chunk()
+{
+    was_new_line_ = false;
+
+    while (true)
+    {
+        for (; position_ != end_ && is_space(*position_); position_++)
+        {
+            if (*position_ == '\n')
+            {
+                line_num_++;
+                was_new_line_ = true;
+            }
+        }
+
+        if (position_ == end_)
+        {
+            eof_ = true;
+            was_new_line_ = true;
+
+            //Lexer counts the last line only if it isn't empty
+            if (begin_ == end_ || end_[-1] == '\n')
+            {
+                line_num_--;
+            }
+
+            break;
+        }
+
+        if (*position_ != comment_char)
+        {
+            break;
+        }
+
+        while (position_ != end_ && *position_ != '\n')
+        {
+            position_++;
+        }
+    }
+
+    for (chunk_end_ = position_; chunk_end_ != end_ && !is_space(*chunk_end_); chunk_end_++);
+}
+
+void MappedLexer::match_token(char const * end, LexemeType type)
+{
+    current_lexeme_ = type;
+    lexeme_value_ = StringRef(position_, end - position_);
+    position_ = end;
+}
+
+/*
+ * returns false when need repeating
+ */
+bool MappedLexer::try_match_token()
+{
+    if (was_new_line_)
+    {
+        was_new_line_ = false;
+        if (current_lexeme_ != LexemeType::UNDEFINED)
+        {
+            current_lexeme_ = LexemeType::EOL;
+            return true;
+        }
+    }
+
+    if (eof_)
+    {
+        current_lexeme_ = LexemeType::EOFL;
+        return true;
+    }
+
+    if (position_ >= chunk_end_)
+    {
+        skip_to_next_chunk();
+        return false;
+    }
+
+    LexemeType type;
+    size_t operator_length = match_operator(position_, chunk_end_, type);
+
+    if (operator_length != 0)
+    {
+        match_token(position_ + operator_length, type);
+        return true;
+    }
+
+    char const * end = position_;
+
+    if (is_digit(*position_))
+    {
+        for (; end != chunk_end_ && is_digit(*end); end++);
+        match_token(end, LexemeType::LITERAL);
+        return true;
+    }
+
+    if (is_ident(*position_))
+    {
+        for (; end != chunk_end_ && is_ident(*end); end++);
+        match_token(end, keyword_type(position_, end - position_));
+        return true;
+    }
+
+    //unexpected character
+    throw SyntaxErrorException(line_num_, "unexpected char");
+}
+
+LexemeType MappedLexer::next_lexeme()
+{
+    while (!try_match_token());
+
+    return current_lexeme();
+}
@@ -0,0 +1,60 @@
+#include <string>
+#include "pp.h"
+#include "parser.h"
+#include "string_ref.h"
+
+#ifndef MAPPED_LEXER_H
+#define MAPPED_LEXER_H
+
+/*
+ * Lexer that scans memory-mapped source file in place,
+ * lexemes are views into the mapping.
+ * Produces the same lexemes and line numbers as Lexer
+ */
+class MappedLexer : public IScanner
+{
+    public:
+        explicit
+        MappedLexer(std::string const & file_name);
+
+        /*
+         * scans [begin, end) of the caller, which starts at line first_line of its source
+         */
+        MappedLexer(char const * begin, char const * end, size_t first_line);
+        virtual ~MappedLexer();
+
+        bool is_open() const { return is_open_; }
+
+        virtual LexemeType current_lexeme() const override { return current_lexeme_; }
+        virtual std::string get_lexeme_value() const override { return lexeme_value_.str(); }
+        virtual size_t get_current_line_number() const override
+        {
+            return line_num_ - (current_lexeme_ == LexemeType::EOL);
+        }
+        virtual LexemeType next_lexeme() override;
+
+        StringRef get_lexeme_view() const { return lexeme_value_; }
+
+        MappedLexer &operator=(MappedLexer const &a) = delete;
+        MappedLexer(MappedLexer const &a) = delete;
+    private:
+        void skip_to_next_chunk();
+        bool try_match_token();
+        void match_token(char const * end, LexemeType type);
+
+        bool is_open_;
+        char const * begin_;
+        char const * end_;
+        size_t mapped_size_;
+
+        char const * position_;
+        char const * chunk_end_;
+
+        LexemeType current_lexeme_;
+        StringRef lexeme_value_;
+        bool eof_;
+        bool was_new_line_;
+        size_t line_num_;
+};
+
+#endif //MAPPED_LEXER_H
@@ -0,0 +1,117 @@
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "pp.h"
+#include "value.h"
+
+#ifndef MEMO_CACHE_H
+#define MEMO_CACHE_H
+
+/*
+ * Bounded cache of the results of a pure function keyed by its arguments.
+ * It's direct-mapped: a result replaces the one of other arguments in its entry.
+ * The table doubles as it fills up to max_entries, so memory stays bounded
+ */
+class MemoCache
+{
+    public:
+        static const size_t initial_entries = 64;
+        static const size_t max_entries = 1 << 16;
+
+        explicit MemoCache(size_t arity) :
+            arity_(arity),
+            entries_num_(0),
+            used_num_(0),
+            hits_(0),
+            misses_(0)
+        {}
+
+        /*
+         * args are arity values, returns false if the result isn't cached
+         */
+        bool find(Value const * args, Value & result)
+        {
+            if (entries_num_ > 0)
+            {
+                size_t entry = entry_of(args);
+
+                if (used_[entry] && std::equal(args, args + arity_, &values_[entry * (arity_ + 1)]))
+                {
+                    result = values_[entry * (arity_ + 1) + arity_];
+                    hits_++;
+                    return true;
+                }
+            }
+
+            misses_++;
+            return false;
+        }
+
+        void insert(Value const * args, Value const & result)
+        {
+            if (used_num_ >= entries_num_ / 2 && entries_num_ < max_entries)
+            {
+                grow();
+            }
+
+            size_t entry = entry_of(args);
+            if (!used_[entry])
+            {
+                used_[entry] = true;
+                used_num_++;
+            }
+
+            std::copy(args, args + arity_, &values_[entry * (arity_ + 1)]);
+            values_[entry * (arity_ + 1) + arity_] = result;
+        }
+
+        size_t get_hits() const { return hits_; }
+        size_t get_misses() const { return misses_; }
+        size_t get_size() const { return used_num_; }
+
+    private:
+        size_t entry_of(Value const * args) const
+        {
+            uint64_t hash = arity_;
+            for (size_t i = 0; i < arity_; i++)
+            {
+                hash = (hash ^ args[i].hash()) * 0x9e3779b97f4a7c15ull;
+                hash ^= hash >> 29;
+            }
+
+            return hash & (entries_num_ - 1);
+        }
+
+        void grow()
+        {
+            std::vector<Value> values;
+            std::vector<unsigned char> used;
+            values.swap(values_);
+            used.swap(used_);
+
+            size_t old_entries_num = entries_num_;
+            entries_num_ = entries_num_ == 0 ? initial_entries : 2 * entries_num_;
+            values_.resize(entries_num_ * (arity_ + 1));
+            used_.resize(entries_num_);
+            used_num_ = 0;
+
+            for (size_t entry = 0; entry < old_entries_num; entry++)
+            {
+                if (used[entry])
+                {
+                    insert(&values[entry * (arity_ + 1)], values[entry * (arity_ + 1) + arity_]);
+                }
+            }
+        }
+
+        size_t arity_;
+        size_t entries_num_;
+        size_t used_num_;
+        //arguments followed by the result for every entry
+        std::vector<Value> values_;
+        std::vector<unsigned char> used_;
+        size_t hits_;
+        size_t misses_;
+};
+
+#endif //MEMO_CACHE_H
@@ -0,0 +1,100 @@
+#include <exception>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "native_stack.h"
+
+char const * native_stack_limit(size_t reserve)
+{
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0)
+    {
+        return nullptr;
+    }
+
+    void * stack_addr = nullptr;
+    size_t stack_size = 0;
+    int result = pthread_attr_getstack(&attr, &stack_addr, &stack_size);
+    pthread_attr_destroy(&attr);
+
+    if (result != 0 || stack_size <= reserve)
+    {
+        return nullptr;
+    }
+
+    //the stack grows down from stack_addr + stack_size
+    return static_cast<char const *>(stack_addr) + reserve;
+}
+
+namespace
+{
+    struct StackTask
+    {
+        std::function<void()> const * body;
+        std::exception_ptr error;
+    };
+
+    void * run_stack_task(void * arg)
+    {
+        StackTask * task = static_cast<StackTask *>(arg);
+
+        try
+        {
+            (*task->body)();
+        }
+        catch (...)
+        {
+            task->error = std::current_exception();
+        }
+
+        return nullptr;
+    }
+}
+
+void run_on_native_stack(size_t size, std::function<void()> const & body)
+{
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size = (size + page_size - 1) / page_size * page_size;
+
+    void * stack = mmap(nullptr, size + page_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    if (stack == MAP_FAILED)
+    {
+        body();
+        return;
+    }
+
+    //guard page below the stack
+    mprotect(stack, page_size, PROT_NONE);
+
+    StackTask task{&body, nullptr};
+    pthread_attr_t attr;
+    pthread_t thread;
+    bool started = false;
+
+    if (pthread_attr_init(&attr) == 0)
+    {
+        started = pthread_attr_setstack(&attr, static_cast<char *>(stack) + page_size, size) == 0
+                  && pthread_create(&thread, &attr, run_stack_task, &task) == 0;
+        pthread_attr_destroy(&attr);
+    }
+
+    if (started)
+    {
+        pthread_join(thread, nullptr);
+    }
+
+    munmap(stack, size + page_size);
+
+    if (!started)
+    {
+        body();
+        return;
+    }
+
+    if (task.error)
+    {
+        std::rethrow_exception(task.error);
+    }
+}
@@ -0,0 +1,21 @@
+#include <cstddef>
+#include <functional>
+
+#ifndef NATIVE_STACK_H
+#define NATIVE_STACK_H
+
+/*
+ * Lowest address the stack of the current thread may grow to, leaving
+ * reserve bytes to unwind and report the overflow; nullptr if unknown
+ */
+char const * native_stack_limit(size_t reserve);
+
+/*
+ * Runs body on a new thread with a stack of the given size. The stack is
+ * mapped lazily, so only its used part takes memory. If such a stack can't
+ * be created, body runs on the current thread. Exceptions thrown by body
+ * are rethrown to the caller
+ */
+void run_on_native_stack(size_t size, std::function<void()> const & body);
+
+#endif //NATIVE_STACK_H
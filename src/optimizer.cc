@@ -0,0 +1,233 @@
+#include "optimizer.h"
+
+static LiteralNode * as_literal(ASTNodePtr node)
+{
+    return dynamic_cast<LiteralNode *>(node);
+}
+
+static bool is_literal(ASTNodePtr node, pp_value_t value)
+{
+    LiteralNode * literal = as_literal(node);
+    return literal != nullptr && literal->get_value() == value;
+}
+
+void Optimizer::optimize(ProgramPtr program)
+{
+    arena_ = &program->get_arena();
+    program->get_root()->accept(this);
+}
+
+void Optimizer::optimize_statement(ASTNodePtr statement, Arena & arena)
+{
+    arena_ = &arena;
+    statement->accept(this);
+}
+
+void Optimizer::optimize_sequence(StatementsSequence const & statements)
+{
+    for (ASTNodePtr const & statement : statements)
+    {
+        statement->accept(this);
+    }
+}
+
+void Optimizer::replace_with_literal(pp_value_t value, ASTNode const * node)
+{
+    LiteralNode * literal = arena_->make<LiteralNode>(value);
+    literal->set_line_num(node->get_line_num());
+    result_ = literal;
+}
+
+/*
+ * values promoted to big ones are left to runtime, a literal can't hold them
+ */
+bool Optimizer::fold(Value const & value, ASTNode const * node)
+{
+    if (!value.is_small())
+    {
+        return false;
+    }
+
+    replace_with_literal(value.get_small(), node);
+    return true;
+}
+
+void Optimizer::visit(RootNode * node)
+{
+    optimize_sequence(node->get_functions());
+    optimize_sequence(node->get_statements());
+}
+
+void Optimizer::visit(FunctionDefinitionNode * node)
+{
+    optimize_sequence(node->get_statements());
+}
+
+void Optimizer::visit(AssignmentNode * node)
+{
+    node->set_expr(optimize_expr(node->get_expr()));
+}
+
+void Optimizer::visit(FunctionCallNode * node)
+{
+    for (size_t i = 0; i < node->get_params().size(); i++)
+    {
+        node->set_param(i, optimize_expr(node->get_params()[i]));
+    }
+
+    result_ = node;
+}
+
+void Optimizer::visit(IfStatementNode * node)
+{
+    node->set_expr(optimize_expr(node->get_expr()));
+    optimize_sequence(node->get_statements());
+}
+
+void Optimizer::visit(WhileStatementNode * node)
+{
+    node->set_expr(optimize_expr(node->get_expr()));
+    optimize_sequence(node->get_statements());
+}
+
+void Optimizer::visit(PrintNode * node)
+{
+    node->set_expr(optimize_expr(node->get_expr()));
+}
+
+void Optimizer::visit(ReadNode *)
+{
+}
+
+void Optimizer::visit(ReturnNode * node)
+{
+    node->set_expr(optimize_expr(node->get_expr()));
+}
+
+void Optimizer::visit(VariableNode * node)
+{
+    result_ = node;
+}
+
+void Optimizer::visit(LiteralNode * node)
+{
+    result_ = node;
+}
+
+void Optimizer::visit(UnaryMinusNode * node)
+{
+    ASTNodePtr expr = optimize_expr(node->get_expr());
+    LiteralNode * literal = as_literal(expr);
+    UnaryMinusNode * inner_minus = dynamic_cast<UnaryMinusNode *>(expr);
+
+    if (literal != nullptr && fold(-Value(literal->get_value()), node))
+    {
+        return;
+    }
+
+    if (inner_minus != nullptr)
+    {
+        result_ = inner_minus->get_expr();
+        return;
+    }
+
+    node->set_expr(expr);
+    result_ = node;
+}
+
+void Optimizer::visit(BinaryOperatorNode * node)
+{
+    ASTNodePtr first_expr = optimize_expr(node->get_first_expr());
+    ASTNodePtr second_expr = optimize_expr(node->get_second_expr());
+
+    node->set_first_expr(first_expr);
+    node->set_second_expr(second_expr);
+    result_ = node;
+
+    LiteralNode * first = as_literal(first_expr);
+    LiteralNode * second = as_literal(second_expr);
+
+    if (first != nullptr && second != nullptr)
+    {
+        pp_value_t a = first->get_value();
+        pp_value_t b = second->get_value();
+
+        switch (node->get_type())
+        {
+            case BinaryOperatorType::PLUS:
+                fold(Value(a) + b, node);
+                break;
+            case BinaryOperatorType::MINUS:
+                fold(Value(a) - b, node);
+                break;
+            case BinaryOperatorType::MULTIPLY:
+                fold(Value(a) * b, node);
+                break;
+            case BinaryOperatorType::DIVIDE:
+                //keep runtime error for division by zero
+                if (b != 0)
+                {
+                    fold(Value(a) / b, node);
+                }
+                break;
+            case BinaryOperatorType::EQUALS:
+                replace_with_literal(a == b, node);
+                break;
+            case BinaryOperatorType::NOT_EQUALS:
+                replace_with_literal(a != b, node);
+                break;
+            case BinaryOperatorType::LESS:
+                replace_with_literal(a < b, node);
+                break;
+            case BinaryOperatorType::LESS_OR_EQALS:
+                replace_with_literal(a <= b, node);
+                break;
+            case BinaryOperatorType::MORE:
+                replace_with_literal(a > b, node);
+                break;
+            case BinaryOperatorType::MORE_OR_EQUALS:
+                replace_with_literal(a >= b, node);
+                break;
+        }
+
+        return;
+    }
+
+    switch (node->get_type())
+    {
+        case BinaryOperatorType::PLUS:
+            if (is_literal(second_expr, 0))
+            {
+                result_ = first_expr;
+            }
+            else if (is_literal(first_expr, 0))
+            {
+                result_ = second_expr;
+            }
+            break;
+        case BinaryOperatorType::MINUS:
+            if (is_literal(second_expr, 0))
+            {
+                result_ = first_expr;
+            }
+            break;
+        case BinaryOperatorType::MULTIPLY:
+            if (is_literal(second_expr, 1))
+            {
+                result_ = first_expr;
+            }
+            else if (is_literal(first_expr, 1))
+            {
+                result_ = second_expr;
+            }
+            break;
+        case BinaryOperatorType::DIVIDE:
+            if (is_literal(second_expr, 1))
+            {
+                result_ = first_expr;
+            }
+            break;
+        default:
+            break;
+    }
+}
@@ -0,0 +1,60 @@
+#include "pp.h"
+#include "ast.h"
+#include "ast_visitor.h"
+#include "value.h"
+
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+/*
+ * Folds constant subexpressions into literals and applies identities
+ * that neither drop evaluation of an operand nor hide a runtime error:
+ * x + 0, 0 + x, x - 0, x * 1, 1 * x, x / 1 and -(-x) become x.
+ * Division by literal zero is left as is to fail at runtime
+ */
+class Optimizer : public ASTNodeVisitor
+{
+    public:
+        Optimizer() : arena_(nullptr), result_(nullptr) {}
+
+        void optimize(ProgramPtr program);
+
+        /*
+         * top-level statement of --stream, replacements are built in the arena given
+         */
+        void optimize_statement(ASTNodePtr statement, Arena & arena);
+
+        virtual void visit(RootNode * node) override;
+        virtual void visit(FunctionDefinitionNode * node) override;
+        virtual void visit(AssignmentNode * node) override;
+        virtual void visit(FunctionCallNode * node) override;
+        virtual void visit(IfStatementNode * node) override;
+        virtual void visit(WhileStatementNode * node) override;
+        virtual void visit(PrintNode * node) override;
+        virtual void visit(ReadNode * node) override;
+        virtual void visit(ReturnNode * node) override;
+        virtual void visit(VariableNode * node) override;
+        virtual void visit(LiteralNode * node) override;
+        virtual void visit(UnaryMinusNode * node) override;
+        virtual void visit(BinaryOperatorNode * node) override;
+
+    private:
+        /*
+         * returns the node expression should be replaced with
+         */
+        ASTNodePtr optimize_expr(ASTNodePtr node)
+        {
+            result_ = node;
+            node->accept(this);
+            return result_;
+        }
+
+        void optimize_sequence(StatementsSequence const & statements);
+        void replace_with_literal(pp_value_t value, ASTNode const * node);
+        bool fold(Value const & value, ASTNode const * node);
+
+        Arena * arena_;
+        ASTNodePtr result_;
+};
+
+#endif //OPTIMIZER_H
@@ -0,0 +1,174 @@
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include "output.h"
+
+FlushPolicy OutputBuffer::default_policy(int fd)
+{
+    return isatty(fd) ? FlushPolicy::LINE : FlushPolicy::SIZE;
+}
+
+void OutputBuffer::flush()
+{
+    if (fd_ < 0)
+    {
+        return;
+    }
+
+    size_t written = 0;
+
+    while (written < size_)
+    {
+        ssize_t result = write(fd_, data_ + written, size_ - written);
+
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            //nobody reads the output anymore, drop it
+            break;
+        }
+
+        written += result;
+    }
+
+    size_ = 0;
+}
+
+void OutputBuffer::make_room()
+{
+    if (policy_ == FlushPolicy::EXIT)
+    {
+        if (buffer_.empty())
+        {
+            //memory of the caller can't grow
+            return;
+        }
+
+        buffer_.resize(buffer_.size() * 2);
+        data_ = buffer_.data();
+        capacity_ = buffer_.size();
+    }
+    else
+    {
+        flush();
+    }
+}
+
+/*
+ * Prints the value near the end of the memory of the caller, if it fits
+ */
+void OutputBuffer::print_last(pp_value_t value)
+{
+    char line[max_value_length];
+    size_t length = format_value(value, line);
+    line[length++] = '\n';
+
+    if (full_ || capacity_ - size_ < length)
+    {
+        full_ = true;
+        return;
+    }
+
+    std::memcpy(data_ + size_, line, length);
+    size_ += length;
+}
+
+/*
+ * A buffer written out takes the line in parts if it's longer than the buffer,
+ * memory keeps lines whole as print_last() does
+ */
+void OutputBuffer::print_big(Value const & value)
+{
+    std::string line = value.to_string() + '\n';
+    char const * p = line.data();
+    char const * end = p + line.size();
+
+    if (fd_ >= 0)
+    {
+        while (static_cast<size_t>(end - p) > capacity_ - size_)
+        {
+            size_t length = capacity_ - size_;
+            std::memcpy(data_ + size_, p, length);
+            size_ += length;
+            p += length;
+            flush();
+        }
+    }
+    else
+    {
+        while (static_cast<size_t>(end - p) > capacity_ - size_ && !buffer_.empty())
+        {
+            make_room();
+        }
+
+        if (full_ || static_cast<size_t>(end - p) > capacity_ - size_)
+        {
+            full_ = true;
+            return;
+        }
+    }
+
+    std::memcpy(data_ + size_, p, end - p);
+    size_ += end - p;
+
+    if (policy_ == FlushPolicy::LINE)
+    {
+        flush();
+    }
+}
+
+/*
+ * Writes decimal representation of value, two digits per step
+ */
+size_t OutputBuffer::format_value(pp_value_t value, char * out)
+{
+    static const char digit_pairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    char digits[max_value_length];
+    char * end = digits + max_value_length;
+    char * p = end;
+
+    unsigned long long abs_value = value < 0 ? 0ULL - value : value;
+
+    while (abs_value >= 100)
+    {
+        size_t pair = (abs_value % 100) * 2;
+        abs_value /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+
+    if (abs_value >= 10)
+    {
+        size_t pair = abs_value * 2;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+    else
+    {
+        *--p = '0' + abs_value;
+    }
+
+    if (value < 0)
+    {
+        *--p = '-';
+    }
+
+    size_t length = end - p;
+    std::memcpy(out, p, length);
+
+    return length;
+}
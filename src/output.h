@@ -0,0 +1,130 @@
+#include <string>
+#include <vector>
+#include "pp.h"
+#include "value.h"
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+/*
+ * LINE - every printed line is written immediately
+ * SIZE - written when the buffer gets full
+ * EXIT - everything is kept until the end of the program
+ */
+enum class FlushPolicy
+{
+    LINE, SIZE, EXIT
+};
+
+const size_t output_buffer_size = 1 << 20;
+const size_t memory_output_initial_size = 1 << 12;
+
+/*
+ * Buffered writer of the print statement output on top of write(2),
+ * or into memory which is never written out: memory of its own growing
+ * as needed, or memory of the caller
+ */
+class OutputBuffer
+{
+    public:
+        OutputBuffer(int fd, FlushPolicy policy) :
+            fd_(fd),
+            policy_(policy),
+            size_(0),
+            buffer_(output_buffer_size),
+            data_(buffer_.data()),
+            capacity_(buffer_.size()),
+            full_(false)
+        {}
+
+        OutputBuffer() :
+            fd_(-1),
+            policy_(FlushPolicy::EXIT),
+            size_(0),
+            buffer_(memory_output_initial_size),
+            data_(buffer_.data()),
+            capacity_(buffer_.size()),
+            full_(false)
+        {}
+
+        /*
+         * lines that don't fit into capacity bytes are dropped and the buffer becomes full
+         */
+        OutputBuffer(char * memory, size_t capacity) :
+            fd_(-1),
+            policy_(FlushPolicy::EXIT),
+            size_(0),
+            data_(memory),
+            capacity_(capacity),
+            full_(false)
+        {}
+
+        ~OutputBuffer() { flush(); }
+
+        void print(pp_value_t value)
+        {
+            if (capacity_ - size_ < max_value_length)
+            {
+                make_room();
+
+                if (capacity_ - size_ < max_value_length)
+                {
+                    print_last(value);
+                    return;
+                }
+            }
+
+            size_ += format_value(value, data_ + size_);
+            data_[size_++] = '\n';
+
+            if (policy_ == FlushPolicy::LINE)
+            {
+                flush();
+            }
+        }
+
+        void print(Value const & value)
+        {
+            if (value.is_small())
+            {
+                print(value.get_small());
+            }
+            else
+            {
+                print_big(value);
+            }
+        }
+
+        void flush();
+
+        /*
+         * output kept in memory
+         */
+        char const * get_data() const { return data_; }
+        size_t get_size() const { return size_; }
+        bool is_full() const { return full_; }
+
+        static FlushPolicy default_policy(int fd);
+
+        OutputBuffer &operator=(OutputBuffer const &a) = delete;
+        OutputBuffer(OutputBuffer const &a) = delete;
+
+    private:
+        //sign, digits and new line
+        static const size_t max_value_length = 24;
+
+        void make_room();
+        void print_last(pp_value_t value);
+        void print_big(Value const & value);
+        static size_t format_value(pp_value_t value, char * out);
+
+        int fd_;
+        FlushPolicy policy_;
+        size_t size_;
+        std::vector<char> buffer_;
+        char * data_;
+        size_t capacity_;
+        bool full_;
+};
+
+#endif //OUTPUT_H
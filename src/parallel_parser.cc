@@ -0,0 +1,177 @@
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include "parallel_parser.h"
+#include "parser.h"
+#include "lexer.h"
+#include "mapped_lexer.h"
+
+const size_t ParallelParser::min_source_size;
+const size_t ParallelParser::min_part_size;
+const size_t ParallelParser::parts_per_job;
+
+/*
+ * Blocks are opened and closed by keywords starting their lines, so the
+ * first word of a line tells whether it's at the top level. Parts are cut
+ * only there; if the count is off for malformed source, a part fails to parse
+ */
+std::vector<ParallelParser::Part> ParallelParser::split() const
+{
+    size_t parts_num = jobs_ * parts_per_job;
+    size_t part_size = std::max<size_t>((end_ - begin_) / parts_num, min_part_size);
+
+    std::vector<Part> parts;
+    char const * part_begin = begin_;
+    size_t part_first_line = 1;
+    size_t line = 1;
+    long depth = 0;
+
+    for (char const * p = begin_; p < end_; p++, line++)
+    {
+        char const * line_end = static_cast<char const *>(std::memchr(p, '\n', end_ - p));
+        if (line_end == nullptr)
+        {
+            line_end = end_;
+        }
+
+        char const * word = p;
+        while (word != line_end && isspace(static_cast<unsigned char>(*word)))
+        {
+            word++;
+        }
+
+        char const * word_end = word;
+        while (word_end != line_end && isident(static_cast<unsigned char>(*word_end)))
+        {
+            word_end++;
+        }
+
+        //empty lines and comments belong to the part before them
+        if (word != line_end && *word != comment_char)
+        {
+            if (depth == 0 && static_cast<size_t>(p - part_begin) >= part_size)
+            {
+                parts.push_back(Part{part_begin, p, part_first_line, 0, nullptr, {}, false});
+                part_begin = p;
+                part_first_line = line;
+            }
+
+            LexemeType type = word != word_end ? keyword_type(word, word_end - word) : LexemeType::UNDEFINED;
+
+            if (type == LexemeType::DEF || type == LexemeType::IF || type == LexemeType::WHILE)
+            {
+                depth++;
+            }
+            else if (type == LexemeType::END && --depth < 0)
+            {
+                return std::vector<Part>();
+            }
+        }
+
+        p = line_end;
+    }
+
+    if (depth != 0)
+    {
+        return std::vector<Part>();
+    }
+
+    parts.push_back(Part{part_begin, end_, part_first_line, 0, nullptr, {}, false});
+    return parts;
+}
+
+void ParallelParser::parse_part(Part & part)
+{
+    //nothing is thrown out of the thread, the failed part is parsed again
+    try
+    {
+        MappedLexer lexer(part.begin, part.end, part.first_line);
+        Parser parser(lexer);
+        part.program.reset(new Program());
+        parser.start(part.program);
+
+        for (ASTNodePtr node; (node = parser.parse_next(part.program->get_arena())) != nullptr; )
+        {
+            part.nodes.push_back(node);
+        }
+
+        part.last_line = lexer.get_current_line_number();
+    }
+    catch (std::exception &)
+    {
+        part.failed = true;
+    }
+}
+
+ProgramPtr ParallelParser::parse_sequentially() const
+{
+    MappedLexer lexer(begin_, end_, 1);
+    Parser parser(lexer);
+    return parser.parse();
+}
+
+ProgramPtr ParallelParser::parse()
+{
+    std::vector<Part> parts = split();
+
+    if (parts.size() < 2)
+    {
+        return parse_sequentially();
+    }
+
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < std::min(jobs_, parts.size()); i++)
+    {
+        threads.emplace_back([&parts, &next]()
+        {
+            for (size_t j = next++; j < parts.size(); j = next++)
+            {
+                parse_part(parts[j]);
+            }
+        });
+    }
+
+    for (std::thread & thread : threads)
+    {
+        thread.join();
+    }
+
+    ProgramPtr program(new Program());
+    Arena & arena = program->get_arena();
+    std::vector<ASTNodePtr> functions;
+    std::vector<ASTNodePtr> statements;
+
+    for (Part & part : parts)
+    {
+        //the first error in source order is reported as it's found without parts
+        if (part.failed)
+        {
+            return parse_sequentially();
+        }
+
+        arena.merge(part.program->get_arena());
+
+        for (ASTNodePtr node : part.nodes)
+        {
+            if (dynamic_cast<FunctionDefinitionNode *>(node) != nullptr)
+            {
+                functions.push_back(node);
+            }
+            else
+            {
+                statements.push_back(node);
+            }
+        }
+    }
+
+    RootNode * root = arena.make<RootNode>(arena.make_array(functions), arena.make_array(statements));
+    root->set_line_num(parts.back().last_line);
+    program->set_root(root);
+
+    return program;
+}
@@ -0,0 +1,61 @@
+#include <string>
+#include <vector>
+#include "pp.h"
+#include "ast.h"
+
+#ifndef PARALLEL_PARSER_H
+#define PARALLEL_PARSER_H
+
+/*
+ * Parses a source held in memory on several threads. A pre-scan splits it
+ * into parts at lines starting top-level definitions and statements, parts are
+ * parsed concurrently, each with the line numbers of the whole source, and
+ * merged into one program in source order. If a part fails, the source is
+ * parsed again on one thread, so errors are the ones Parser reports
+ */
+class ParallelParser
+{
+    public:
+        //smaller sources aren't worth the threads
+        static const size_t min_source_size = 1 << 20;
+        static const size_t min_part_size = 1 << 18;
+        //parts per thread, evening out parts of different cost
+        static const size_t parts_per_job = 4;
+
+        ParallelParser(char const * begin, char const * end, size_t jobs) :
+            begin_(begin),
+            end_(end),
+            jobs_(jobs)
+        {}
+
+        ProgramPtr parse();
+
+        ParallelParser &operator=(ParallelParser const &a) = delete;
+        ParallelParser(ParallelParser const &a) = delete;
+
+    private:
+        struct Part
+        {
+            char const * begin;
+            char const * end;
+            size_t first_line;
+            //line the parser ended on, which the root of the last part gets
+            size_t last_line;
+            ProgramPtr program;
+            std::vector<ASTNodePtr> nodes;
+            bool failed;
+        };
+
+        /*
+         * no parts if the nesting of blocks doesn't add up
+         */
+        std::vector<Part> split() const;
+        static void parse_part(Part & part);
+        ProgramPtr parse_sequentially() const;
+
+        char const * begin_;
+        char const * end_;
+        size_t jobs_;
+};
+
+#endif //PARALLEL_PARSER_H
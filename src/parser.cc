@@ -7,7 +7,7 @@
 #include "parser.h"
 #include "ast.h"
 
-std::vector<std::vector<LexemeType>> Parser::operators_ = 
+const std::vector<std::vector<LexemeType>> Parser::operators_ = 
 {
     std::vector<LexemeType>{LexemeType::MULTIPLY, LexemeType::DIVIDE},
     std::vector<LexemeType>{LexemeType::PLUS, LexemeType::MINUS},
@@ -23,7 +23,7 @@ unsigned short int Parser::operator_priority(LexemeType type)
 {
     for (size_t i = 0; i < operators_.size(); i++) 
     {
-        for (LexemeType & op_type : operators_[i]) {
+        for (LexemeType op_type : operators_[i]) {
             if (op_type == type)
             {
                 return operators_.size() - i;
@@ -39,42 +39,70 @@ bool Parser::is_operator(LexemeType type)
     return operator_priority(type) != 0;
 }
 
-ASTNodePtr Parser::parse() 
+ProgramPtr Parser::parse() 
 {
-    scanner_.next_lexeme();
-    LexemeType current_lex = scanner_.current_lexeme();
+    ProgramPtr program(new Program());
+    start(program);
     
-    StatementsSequence functions;
-    StatementsSequence statements;
+    std::vector<ASTNodePtr> functions;
+    std::vector<ASTNodePtr> statements;
     
-    while (current_lex != LexemeType::EOFL) 
+    while (ASTNodePtr node = parse_next(program->get_arena())) 
     {
-        if (current_lex == LexemeType::DEF) 
+        if (dynamic_cast<FunctionDefinitionNode *>(node) != nullptr) 
         {
-            functions.push_back(parse_function_definition());
+            functions.push_back(node);
         } 
         else 
         {
-            statements.push_back(parse_statement());
+            statements.push_back(node);
         }
+    }
 
-        assert_current_lexeme(LexemeType::EOL);
-        current_lex = scanner_.next_lexeme();
+    arena_ = program_arena_;
+    ASTNodePtr root = build_ast_node_ptr<RootNode>(arena_->make_array(functions), arena_->make_array(statements));
+    program->set_root(static_cast<RootNode *>(root));
+
+    return program;
+}
+
+void Parser::start(ProgramPtr program)
+{
+    program_arena_ = &program->get_arena();
+    arena_ = program_arena_;
+    names_.clear();
+
+    scanner_.next_lexeme();
+}
+
+ASTNodePtr Parser::parse_next(Arena & arena)
+{
+    LexemeType current_lex = scanner_.current_lexeme();
+    if (current_lex == LexemeType::EOFL)
+    {
+        return nullptr;
     }
 
-    return build_ast_node_ptr(new RootNode(functions, statements));
+    arena_ = &arena;
+    ASTNodePtr node = current_lex == LexemeType::DEF ? parse_function_definition() : parse_statement();
+
+    assert_current_lexeme(LexemeType::EOL);
+    scanner_.next_lexeme();
+
+    return node;
 }
 
 ASTNodePtr Parser::parse_function_definition() 
 {
-    
+    //block nodes are built after the body, but belong to the header line
+    size_t line = scanner_.get_current_line_number();
     assert_next_lexeme(LexemeType::IDENT);
     
-    std::string name = scanner_.get_lexeme_value();
+    StringRef name = intern(scanner_.get_lexeme_value());
 
     assert_next_lexeme(LexemeType::L_PARENTHESIS);
     
-    std::vector<std::string> params;
+    std::vector<StringRef> params;
     
     while (scanner_.next_lexeme() != LexemeType::R_PARENTHESIS) 
     {
@@ -86,7 +114,7 @@ ASTNodePtr Parser::parse_function_definition()
 
         assert_current_lexeme(LexemeType::IDENT);
 
-        params.push_back(scanner_.get_lexeme_value());
+        params.push_back(intern(scanner_.get_lexeme_value()));
     }
 
     assert_next_lexeme(LexemeType::COLON); 
@@ -94,11 +122,12 @@ ASTNodePtr Parser::parse_function_definition()
 
     StatementsSequence statements = parse_statements_sequence();
 
-    return build_ast_node_ptr(
-            new FunctionDefinitionNode(
-                name, params, statements 
-            )
+    ASTNodePtr definition = build_ast_node_ptr<FunctionDefinitionNode>(
+        name, arena_->make_array(params), statements 
     );
+    definition->set_line_num(line);
+
+    return definition;
 }   
 
 ASTNodePtr Parser::parse_statement() 
@@ -108,18 +137,28 @@ ASTNodePtr Parser::parse_statement()
     //assignment or void function call
     if (current_lex == LexemeType::IDENT) 
     {
-        std::string ident = scanner_.get_lexeme_value();
+        StringRef ident = intern(scanner_.get_lexeme_value());
         
         if (scanner_.next_lexeme() == LexemeType::ASSIGNMENT) 
         {
-            scanner_.next_lexeme();
-            return build_ast_node_ptr(
-                new AssignmentNode(ident, parse_expression())
-            );
+            if (scanner_.next_lexeme() == LexemeType::SPAWN)
+            {
+                assert_next_lexeme(LexemeType::IDENT);
+                StringRef name = intern(scanner_.get_lexeme_value());
+                scanner_.next_lexeme();
+
+                ASTNodePtr call = parse_function_call(name);
+                return build_ast_node_ptr<SpawnNode>(ident, static_cast<FunctionCallNode *>(call));
+            }
+
+            return build_ast_node_ptr<AssignmentNode>(ident, parse_expression());
         }
         
         //function call with EOL
-        return parse_function_call(ident);
+        ASTNodePtr call = parse_function_call(ident);
+        static_cast<FunctionCallNode *>(call)->set_statement(true);
+
+        return call;
     }
 
     //if/while
@@ -139,9 +178,15 @@ ASTNodePtr Parser::parse_statement()
     {
         current_lex = scanner_.next_lexeme();
         
-        return build_ast_node_ptr(
-            new ReturnNode(parse_expression()) 
-        ); 
+        return build_ast_node_ptr<ReturnNode>(parse_expression()); 
+    }
+
+    if (current_lex == LexemeType::SYNC)
+    {
+        ASTNodePtr sync = build_ast_node_ptr<SyncNode>();
+        scanner_.next_lexeme();
+
+        return sync;
     }
     
     throw_error("unexpected statement");
@@ -151,6 +196,7 @@ ASTNodePtr Parser::parse_statement()
 
 ASTNodePtr Parser::parse_block_statement(LexemeType type) 
 {
+    size_t line = scanner_.get_current_line_number();
     scanner_.next_lexeme(); 
     
     ASTNodePtr expression = parse_expression();
@@ -161,29 +207,23 @@ ASTNodePtr Parser::parse_block_statement(LexemeType type)
     StatementsSequence statements = parse_statements_sequence();
     assert_current_lexeme(LexemeType::EOL);
     
+    ASTNodePtr block = nullptr;
+
     if (type == LexemeType::IF) 
     {
-        return build_ast_node_ptr(
-                new IfStatementNode(
-                    expression,
-                    statements
-                )
-        );
+        block = build_ast_node_ptr<IfStatementNode>(expression, statements);
     }
-
-    if (type == LexemeType::WHILE) 
+    else if (type == LexemeType::WHILE) 
     {
-        return build_ast_node_ptr(
-                new WhileStatementNode(
-                    expression,
-                    statements
-                )
-        );
+        block = build_ast_node_ptr<WhileStatementNode>(expression, statements);
+    }
+    else
+    {
+        throw_error("unknown block operator");
     }
 
-    throw_error("unknown block operator");
-
-    return nullptr;
+    block->set_line_num(line);
+    return block;
 }
 
 StatementsSequence Parser::parse_statements_sequence() 
@@ -191,7 +231,7 @@ StatementsSequence Parser::parse_statements_sequence()
     //it's always starts with EOL
     scanner_.next_lexeme();
     
-    StatementsSequence result;
+    std::vector<ASTNodePtr> result;
 
     LexemeType current_lex = scanner_.current_lexeme();
 
@@ -205,7 +245,7 @@ StatementsSequence Parser::parse_statements_sequence()
     
     scanner_.next_lexeme();
 
-    return result;
+    return arena_->make_array(result);
 }
 
 ASTNodePtr Parser::parse_io_statement(LexemeType type) 
@@ -213,13 +253,11 @@ ASTNodePtr Parser::parse_io_statement(LexemeType type)
     if (type == LexemeType::READ) 
     {
         assert_next_lexeme(LexemeType::IDENT);
-        std::string var_name = scanner_.get_lexeme_value();
+        StringRef var_name = intern(scanner_.get_lexeme_value());
         
         scanner_.next_lexeme();
 
-        return build_ast_node_ptr(
-            new ReadNode(var_name)
-        );
+        return build_ast_node_ptr<ReadNode>(var_name);
     }
 
     if (type == LexemeType::PRINT) 
@@ -227,9 +265,7 @@ ASTNodePtr Parser::parse_io_statement(LexemeType type)
         scanner_.next_lexeme();
         ASTNodePtr expression = parse_expression();
         
-        return build_ast_node_ptr(
-            new PrintNode(expression)
-        );
+        return build_ast_node_ptr<PrintNode>(expression);
     }
     
     throw_error("unknown io operation");
@@ -237,7 +273,7 @@ ASTNodePtr Parser::parse_io_statement(LexemeType type)
     return nullptr;
 }
 
-ASTNodePtr Parser::parse_function_call(std::string name)
+ASTNodePtr Parser::parse_function_call(StringRef name)
 {
     assert_current_lexeme(LexemeType::L_PARENTHESIS);
     scanner_.next_lexeme();
@@ -257,7 +293,7 @@ ASTNodePtr Parser::parse_function_call(std::string name)
     
     scanner_.next_lexeme();
     
-    return build_ast_node_ptr(new FunctionCallNode(name, expressions));
+    return build_ast_node_ptr<FunctionCallNode>(name, arena_->make_array(expressions));
 }
 
 ASTNodePtr Parser::parse_expression() 
@@ -289,7 +325,7 @@ ASTNodePtr Parser::parse_expression()
         {
             //unary minus
             scanner_.next_lexeme();
-            operand = build_ast_node_ptr(new UnaryMinusNode(parse_expression_operand()));
+            operand = build_ast_node_ptr<UnaryMinusNode>(parse_expression_operand());
         }
         else
         {
@@ -360,7 +396,7 @@ ASTNodePtr Parser::build_binary_operator_node(ASTNodePtr a, ASTNodePtr b, Lexeme
             throw_error("unknown binary operator");
     }
     
-    return build_ast_node_ptr(new BinaryOperatorNode(bin_op_type, a, b));
+    return build_ast_node_ptr<BinaryOperatorNode>(bin_op_type, a, b);
 }
 
 ASTNodePtr Parser::parse_expression_operand()
@@ -397,7 +433,7 @@ ASTNodePtr Parser::parse_expression_identifier()
 {
     assert_current_lexeme(LexemeType::IDENT);
 
-    std::string ident = scanner_.get_lexeme_value();
+    StringRef ident = intern(scanner_.get_lexeme_value());
     
     if (scanner_.next_lexeme() == LexemeType::L_PARENTHESIS) 
     {
@@ -406,19 +442,48 @@ ASTNodePtr Parser::parse_expression_identifier()
     } 
     
     //variable identifier
-    return build_ast_node_ptr(new VariableNode(ident));
+    return build_ast_node_ptr<VariableNode>(ident);
 }
 
+/*
+ * literals beyond pp_value_t become arithmetic on parts of 18 digits,
+ * which promotes to the big value when it's evaluated
+ */
 ASTNodePtr Parser::parse_literal() 
 {
     assert_current_lexeme(LexemeType::LITERAL);
     
-    std::stringstream ss;
-    ss << scanner_.get_lexeme_value();
+    std::string digits = scanner_.get_lexeme_value();
+    std::stringstream ss(digits);
     pp_value_t value;
-    ss >> value;
+
+    if (!(ss >> value))
+    {
+        static const size_t part_digits = 18;
+        static const pp_value_t part_base = 1000000000000000000LL;
+
+        ASTNodePtr number = nullptr;
+        size_t length = digits.size() % part_digits == 0 ? part_digits : digits.size() % part_digits;
+
+        for (size_t position = 0; position < digits.size(); position += length, length = part_digits)
+        {
+            ASTNodePtr part = build_ast_node_ptr<LiteralNode>(std::stoll(digits.substr(position, length)));
+
+            if (number != nullptr)
+            {
+                number = build_ast_node_ptr<BinaryOperatorNode>(BinaryOperatorType::MULTIPLY, number,
+                    build_ast_node_ptr<LiteralNode>(part_base));
+                part = build_ast_node_ptr<BinaryOperatorNode>(BinaryOperatorType::PLUS, number, part);
+            }
+
+            number = part;
+        }
+
+        scanner_.next_lexeme();
+        return number;
+    }
 
     scanner_.next_lexeme();
-    return build_ast_node_ptr(new LiteralNode(value));
+    return build_ast_node_ptr<LiteralNode>(value);
 }
 
@@ -1,6 +1,9 @@
 #include <string>
 #include <memory>
 #include <sstream>
+#include <vector>
+#include <unordered_map>
+#include <utility>
 
 #include "pp.h"
 #include "ast.h"
@@ -20,7 +23,8 @@ enum class LexemeType : short int
     IF, WHILE, COLON, COMMA, //18
     READ, PRINT, //22
     EOFL, EOL, //24
-    UNDEFINED //26
+    UNDEFINED, //26
+    SPAWN, SYNC //27
 };
 
 inline std::ostream& operator << (std::ostream& os, const LexemeType& obj)
@@ -32,6 +36,8 @@ inline std::ostream& operator << (std::ostream& os, const LexemeType& obj)
 class IScanner 
 {
     public:
+        virtual ~IScanner() {}
+
         virtual LexemeType current_lexeme() const = 0;
         virtual std::string get_lexeme_value() const = 0;
         virtual size_t get_current_line_number() const = 0;
@@ -48,9 +54,18 @@ class SyntaxErrorException : public LineNumberException {
 
 class Parser {
     public: 
-        Parser(IScanner & scanner) : scanner_(scanner) {}
+        Parser(IScanner & scanner) : scanner_(scanner), arena_(nullptr), program_arena_(nullptr) {}
         
-        ASTNodePtr parse();
+        ProgramPtr parse();
+
+        /*
+         * Parses one definition or top-level statement at a time: start() once,
+         * then parse_next() until it returns nullptr. Names are kept in the arena
+         * of the program, nodes are built in the arena given
+         */
+        void start(ProgramPtr program);
+        ASTNodePtr parse_next(Arena & arena);
+        bool at_definition() const { return scanner_.current_lexeme() == LexemeType::DEF; }
 
     private:
         ASTNodePtr         parse_function_definition();
@@ -58,17 +73,32 @@ class Parser {
         ASTNodePtr         parse_block_statement(LexemeType type);
         ASTNodePtr         parse_io_statement(LexemeType type);
         StatementsSequence parse_statements_sequence();
-        ASTNodePtr         parse_function_call(std::string name);
+        ASTNodePtr         parse_function_call(StringRef name);
         ASTNodePtr         parse_expression();
         ASTNodePtr         parse_expression_operand();
         ASTNodePtr         parse_expression_identifier();
         ASTNodePtr         parse_literal();
         ASTNodePtr         build_binary_operator_node(ASTNodePtr a, ASTNodePtr b, LexemeType type);
         
-        ASTNodePtr build_ast_node_ptr(ASTNode * node) const 
+        template<class T, class... Args>
+        ASTNodePtr build_ast_node_ptr(Args &&... args)
         {
+            T * node = arena_->make<T>(std::forward<Args>(args)...);
             node->set_line_num(scanner_.get_current_line_number());
-            return ASTNodePtr(node);
+            return node;
+        }
+
+        /*
+         * identifiers are stored once per program 
+         */
+        StringRef intern(std::string const & name)
+        {
+            auto it = names_.find(name);
+            if (it == names_.end())
+            {
+                it = names_.insert(std::make_pair(name, program_arena_->make_string(name))).first;
+            }
+            return it->second;
         }
 
         void throw_error(std::string const & msg) { throw SyntaxErrorException(scanner_.get_current_line_number(), msg); }
@@ -94,11 +124,15 @@ class Parser {
         }
 
         IScanner & scanner_;
+        //where nodes are built
+        Arena * arena_;
+        Arena * program_arena_;
+        std::unordered_map<std::string, StringRef> names_;
         
         static unsigned short int operator_priority(LexemeType type);
         static bool is_operator(LexemeType type);
 
-        static std::vector<std::vector<LexemeType>> operators_;
+        static const std::vector<std::vector<LexemeType>> operators_;
 };
 
 #endif //PARSER_H
@@ -1,39 +1,1012 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 #include "parser.h"
 #include "ast.h"
 #include "lexer.h"
+#include "mapped_lexer.h"
 #include "interpreter.h"
+#include "resolver.h"
+#include "linker.h"
+#include "program_cache.h"
+#include "optimizer.h"
+#include "specializer.h"
+#include "ast_printer.h"
+#include "compiler.h"
+#include "vm.h"
+#include "output.h"
+#include "input.h"
+#include "stats.h"
+#include "profiler.h"
+#include "native_stack.h"
+#include "purity.h"
+#include "c_emitter.h"
+#include "batch.h"
+#include "parallel_parser.h"
 
-void display_usage() 
+enum class Engine
 {
-    std::cout << "Usage: pp <source-file>" << std::endl;
+    TREE, VM
+};
+
+struct Options
+{
+    Options() :
+        engine(Engine::TREE),
+        flush_policy(OutputBuffer::default_policy(STDOUT_FILENO)),
+        mmap(false),
+        optimize(true),
+        dump_ast(false),
+        stats(false),
+        max_depth(Interpreter::default_max_depth),
+        memoize(false),
+        memoize_stats(false),
+        stream(false),
+        jit(false),
+        jit_log(false),
+        compile(false),
+        parse_jobs(std::max(std::thread::hardware_concurrency(), 1u)),
+        spawn_threads(std::max(std::thread::hardware_concurrency(), 1u) - 1),
+        jobs(0)
+    {}
+
+    Engine engine;
+    FlushPolicy flush_policy;
+    bool mmap;
+    bool optimize;
+    bool dump_ast;
+    bool stats;
+    size_t max_depth;
+    bool memoize;
+    bool memoize_stats;
+    bool stream;
+    bool jit;
+    bool jit_log;
+    std::string c_file;
+    bool compile;
+    std::string output_file;
+    size_t parse_jobs;
+    size_t spawn_threads;
+    std::string profile_file;
+    std::string cache_dir;
+    std::string source_file;
+    //0 unless scripts run as a batch
+    size_t jobs;
+    std::vector<std::string> batch_files;
+    std::string manifest_file;
+};
+
+void display_usage()
+{
+    std::cout << "Usage: pp [options] <source-file>" << std::endl;
+    std::cout << "       pp --jobs N [options] <source-file>... [--manifest FILE]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --engine=tree|vm         execution engine, tree-walking interpreter by default" << std::endl;
+    std::cout << "  --flush=line|size|exit   when print output is written, line for terminals" << std::endl;
+    std::cout << "                           and size for everything else by default" << std::endl;
+    std::cout << "  --mmap                   lex memory-mapped source file in place" << std::endl;
+    std::cout << "  -O0, -O1                 disable/enable constant folding and specialized nodes" << std::endl;
+    std::cout << "                           of the tree engine, enabled by default" << std::endl;
+    std::cout << "  --dump-ast               print the optimized program instead of running it" << std::endl;
+    std::cout << "  --stats                  report phase times and execution counters to stderr," << std::endl;
+    std::cout << "                           parse time excludes lexing unless it's parallel" << std::endl;
+    std::cout << "  --max-depth=N            maximum depth of function calls, " << Interpreter::default_max_depth << " by default" << std::endl;
+    std::cout << "  --memoize=off|auto       cache results of pure functions by their arguments," << std::endl;
+    std::cout << "                           off by default, tree engine only" << std::endl;
+    std::cout << "  --memoize-stats          report cache hit rates to stderr" << std::endl;
+    std::cout << "  --stream                 run top-level statements as they are parsed, holding" << std::endl;
+    std::cout << "                           only definitions and one statement in memory" << std::endl;
+    std::cout << "  --jit                    compile hot functions of the tree engine to x86-64 code" << std::endl;
+    std::cout << "  --jit-log                report compiled functions and ones left to the interpreter" << std::endl;
+    std::cout << "                           to stderr" << std::endl;
+    std::cout << "  --emit-c FILE            translate the program to C instead of running it" << std::endl;
+    std::cout << "  --compile -o FILE        build an executable with the system C compiler, $CC or cc" << std::endl;
+    std::cout << "  --cache-dir DIR          keep parsed programs in DIR to skip parsing them again" << std::endl;
+    std::cout << "  --parse-jobs N           threads parsing sources of 1 MB and more, the number" << std::endl;
+    std::cout << "                           of cores by default" << std::endl;
+    std::cout << "  --spawn-threads N        threads running spawned calls besides the one running" << std::endl;
+    std::cout << "                           the program, the number of cores less one by default" << std::endl;
+    std::cout << "  --jobs N                 run the scripts as a batch on N threads, each output" << std::endl;
+    std::cout << "                           written as a whole in the order of the scripts" << std::endl;
+    std::cout << "  --manifest FILE          scripts of the batch, a \"<source-file> [input-file]\" line each" << std::endl;
+    std::cout << "  --profile=FILE           profile lines and functions of the tree engine, write" << std::endl;
+    std::cout << "                           folded stacks to FILE and a summary to stderr" << std::endl;
 }
 
-int main(int argc, char const * argv[]) 
+/*
+ * returns false if arguments are malformed
+ */
+bool parse_options(int argc, char const * argv[], Options & options)
 {
-    if (argc < 2) 
+    for (int i = 1; i < argc; i++)
     {
-        display_usage();
-        return 1;
+        std::string arg = argv[i];
+
+        if (arg == "--engine=tree")
+        {
+            options.engine = Engine::TREE;
+        }
+        else if (arg == "--engine=vm")
+        {
+            options.engine = Engine::VM;
+        }
+        else if (arg == "--flush=line")
+        {
+            options.flush_policy = FlushPolicy::LINE;
+        }
+        else if (arg == "--flush=size")
+        {
+            options.flush_policy = FlushPolicy::SIZE;
+        }
+        else if (arg == "--flush=exit")
+        {
+            options.flush_policy = FlushPolicy::EXIT;
+        }
+        else if (arg == "--mmap")
+        {
+            options.mmap = true;
+        }
+        else if (arg == "-O0")
+        {
+            options.optimize = false;
+        }
+        else if (arg == "-O1")
+        {
+            options.optimize = true;
+        }
+        else if (arg == "--dump-ast")
+        {
+            options.dump_ast = true;
+        }
+        else if (arg == "--stats")
+        {
+            options.stats = true;
+        }
+        else if (arg == "--memoize=off")
+        {
+            options.memoize = false;
+        }
+        else if (arg == "--memoize=auto")
+        {
+            options.memoize = true;
+        }
+        else if (arg == "--memoize-stats")
+        {
+            options.memoize_stats = true;
+        }
+        else if (arg == "--stream")
+        {
+            options.stream = true;
+        }
+        else if (arg == "--jit")
+        {
+            options.jit = true;
+        }
+        else if (arg == "--jit-log")
+        {
+            options.jit_log = true;
+        }
+        else if (arg == "--emit-c" && i + 1 < argc)
+        {
+            options.c_file = argv[++i];
+        }
+        else if (arg == "--cache-dir" && i + 1 < argc)
+        {
+            options.cache_dir = argv[++i];
+        }
+        else if ((arg == "--jobs" || arg == "--parse-jobs") && i + 1 < argc)
+        {
+            char * end = nullptr;
+            std::string value = argv[++i];
+            unsigned long long jobs = std::strtoull(value.c_str(), &end, 10);
+
+            if (value.empty() || *end != '\0' || jobs == 0 || value[0] == '-')
+            {
+                std::cerr << "invalid " << arg << " " << value << std::endl;
+                return false;
+            }
+
+            (arg == "--jobs" ? options.jobs : options.parse_jobs) = jobs;
+        }
+        else if (arg == "--spawn-threads" && i + 1 < argc)
+        {
+            char * end = nullptr;
+            std::string value = argv[++i];
+            unsigned long long threads = std::strtoull(value.c_str(), &end, 10);
+
+            if (value.empty() || *end != '\0' || value[0] == '-')
+            {
+                std::cerr << "invalid " << arg << " " << value << std::endl;
+                return false;
+            }
+
+            options.spawn_threads = threads;
+        }
+        else if (arg == "--manifest" && i + 1 < argc)
+        {
+            options.manifest_file = argv[++i];
+        }
+        else if (arg == "--compile")
+        {
+            options.compile = true;
+        }
+        else if (arg == "-o" && i + 1 < argc)
+        {
+            options.output_file = argv[++i];
+        }
+        else if (arg.compare(0, 12, "--max-depth=") == 0 && arg.size() > 12)
+        {
+            char * end = nullptr;
+            unsigned long long max_depth = std::strtoull(arg.c_str() + 12, &end, 10);
+
+            if (*end != '\0' || max_depth == 0 || arg[12] == '-')
+            {
+                std::cerr << "invalid " << arg << std::endl;
+                return false;
+            }
+
+            options.max_depth = max_depth;
+        }
+        else if (arg.compare(0, 10, "--profile=") == 0 && arg.size() > 10)
+        {
+            options.profile_file = arg.substr(10);
+        }
+        else if (arg.size() > 1 && arg[0] == '-')
+        {
+            std::cerr << "unknown option " << arg << std::endl;
+            return false;
+        }
+        else
+        {
+            options.batch_files.push_back(arg);
+        }
     }
 
-    std::ifstream src_fstream(argv[1], std::ios::in);
-    
-    Lexer lexer(src_fstream);
-    Parser parser(lexer);
-    
-    try 
+    if (!options.profile_file.empty() && (options.stats || options.engine == Engine::VM))
     {
-        ASTNodePtr root = parser.parse();
-        Interpreter interpreter;
-        interpreter.execute(root);
-    } 
-    catch (LineNumberException &e) 
+        std::cerr << "--profile can't be combined with --stats or --engine=vm" << std::endl;
+        return false;
+    }
+
+    if (options.memoize && options.engine == Engine::VM)
+    {
+        std::cerr << "--memoize=auto can't be combined with --engine=vm" << std::endl;
+        return false;
+    }
+
+    if (!options.cache_dir.empty() && options.mmap)
+    {
+        std::cerr << "--cache-dir can't be combined with --mmap" << std::endl;
+        return false;
+    }
+
+    if (options.compile != !options.output_file.empty())
+    {
+        std::cerr << "--compile and -o go together" << std::endl;
+        return false;
+    }
+
+    if ((options.compile || !options.c_file.empty()) && (options.memoize || !options.profile_file.empty()))
+    {
+        std::cerr << "--emit-c and --compile can't be combined with --memoize or --profile" << std::endl;
+        return false;
+    }
+
+    if (options.jit && (options.engine == Engine::VM || options.stats || options.memoize
+                        || !options.profile_file.empty() || options.compile || !options.c_file.empty()))
+    {
+        std::cerr << "--jit can't be combined with --engine=vm, --stats, --memoize, --profile or C output" << std::endl;
+        return false;
+    }
+
+    if (options.stream && (options.engine == Engine::VM || options.stats || !options.profile_file.empty()
+                           || options.dump_ast || !options.cache_dir.empty() || options.compile || !options.c_file.empty()))
+    {
+        std::cerr << "--stream runs the tree engine only, without --stats, --profile, --dump-ast, --cache-dir or C output" << std::endl;
+        return false;
+    }
+
+    if (options.jit_log && !options.jit)
+    {
+        std::cerr << "--jit-log requires --jit" << std::endl;
+        return false;
+    }
+
+    if (options.memoize_stats && !options.memoize)
+    {
+        std::cerr << "--memoize-stats requires --memoize=auto" << std::endl;
+        return false;
+    }
+
+    if (options.jobs == 0)
+    {
+        if (!options.manifest_file.empty())
+        {
+            std::cerr << "--manifest requires --jobs" << std::endl;
+            return false;
+        }
+
+        if (options.batch_files.size() != 1)
+        {
+            return false;
+        }
+
+        options.source_file = options.batch_files.front();
+        return true;
+    }
+
+    if (options.engine == Engine::VM || options.mmap || options.dump_ast || options.stats || options.memoize_stats
+        || options.stream || options.jit_log || !options.profile_file.empty() || !options.cache_dir.empty()
+        || options.compile || !options.c_file.empty())
+    {
+        std::cerr << "--jobs runs the tree engine only, without --mmap, --dump-ast, --stats, --memoize-stats," << std::endl;
+        std::cerr << "--stream, --jit-log, --profile, --cache-dir or C output" << std::endl;
+        return false;
+    }
+
+    return !options.batch_files.empty() || !options.manifest_file.empty();
+}
+
+/*
+ * returns nullptr if the source file can't be opened
+ */
+std::unique_ptr<IScanner> open_scanner(Options const & options, std::ifstream & src_fstream)
+{
+    if (options.mmap)
+    {
+        MappedLexer * mapped_lexer = new MappedLexer(options.source_file);
+        std::unique_ptr<IScanner> scanner(mapped_lexer);
+
+        if (!mapped_lexer->is_open())
+        {
+            return nullptr;
+        }
+
+        return scanner;
+    }
+
+    src_fstream.open(options.source_file, std::ios::in);
+    return std::unique_ptr<IScanner>(new Lexer(src_fstream));
+}
+
+/*
+ * returns false if the file can't be read
+ */
+bool read_source(std::string const & path, std::string & source)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    source.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !file.bad();
+}
+
+/*
+ * whether the source is parsed by ParallelParser, which needs it in memory
+ */
+bool parse_in_parallel(Options const & options)
+{
+    struct stat file_stat;
+
+    return options.parse_jobs > 1 && !options.mmap && !options.stream
+           && stat(options.source_file.c_str(), &file_stat) == 0
+           && static_cast<size_t>(file_stat.st_size) >= ParallelParser::min_source_size;
+}
+
+/*
+ * runs the C compiler, returns false if it fails
+ */
+bool run_c_compiler(std::string const & c_file, std::string const & output_file)
+{
+    char const * cc = std::getenv("CC");
+    std::vector<char const *> args = {
+        cc != nullptr && *cc != '\0' ? cc : "cc", "-O2", "-o", output_file.c_str(), c_file.c_str(), "-pthread", nullptr
+    };
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        execvp(args[0], const_cast<char * const *>(args.data()));
+        _exit(127);
+    }
+
+    int status = 0;
+    if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        std::cerr << "C compiler " << args[0] << " failed" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * writes the program as C to the --emit-c file, or to a temporary one
+ * to be compiled, returns false on failure
+ */
+bool translate_to_c(Options const & options, ASTNodePtr root)
+{
+    std::string c_file = options.c_file;
+    bool temporary = c_file.empty();
+
+    if (temporary)
+    {
+        char name[] = "/tmp/ppXXXXXX.c";
+        int fd = mkstemps(name, 2);
+
+        if (fd < 0)
+        {
+            std::cerr << "can't create a temporary file" << std::endl;
+            return false;
+        }
+
+        close(fd);
+        c_file = name;
+    }
+
+    std::ofstream c_stream(c_file);
+    CEmitter emitter(c_stream, options.max_depth);
+    emitter.emit(root, options.source_file);
+    c_stream.close();
+
+    bool result = !c_stream.fail();
+    if (!result)
+    {
+        std::cerr << "can't write " << c_file << std::endl;
+    }
+    else if (options.compile)
+    {
+        result = run_c_compiler(c_file, options.output_file);
+    }
+
+    if (temporary)
+    {
+        unlink(c_file.c_str());
+    }
+
+    return result;
+}
+
+/*
+ * reports the error the way every run does
+ */
+void print_error(LineNumberException const & e)
+{
+    LinkException const * link_error = dynamic_cast<LinkException const *>(&e);
+
+    if (link_error == nullptr)
     {
         std::cerr << "line number " << e.get_line_number() << ": " << e.what() << std::endl;
+        return;
+    }
+
+    for (LinkException::Error const & error : link_error->get_errors())
+    {
+        std::cerr << "line number " << error.line << ": " << error.msg << std::endl;
+    }
+}
+
+/*
+ * First pass of --stream: definitions are kept, the statements are parsed
+ * to collect globals and calls and dropped. Returns the root with the definitions
+ * ready to run, resolver and linker are left to resolve and link the statements.
+ * Syntax and link errors are thrown before anything runs
+ */
+RootNode * prescan_stream(Options const & options, ProgramPtr program, Resolver & resolver, Linker & linker)
+{
+    std::ifstream src_fstream;
+    std::unique_ptr<IScanner> scanner = open_scanner(options, src_fstream);
+    Parser parser(*scanner);
+    Arena statement_arena;
+    std::vector<ASTNodePtr> functions;
+
+    parser.start(program);
+    resolver.start(program);
+
+    while (true)
+    {
+        bool is_definition = parser.at_definition();
+        ASTNodePtr node = parser.parse_next(is_definition ? program->get_arena() : statement_arena);
+
+        if (node == nullptr)
+        {
+            break;
+        }
+
+        if (is_definition)
+        {
+            functions.push_back(node);
+        }
+        else
+        {
+            resolver.collect_globals(node);
+            linker.collect_calls(node);
+            statement_arena.clear();
+        }
+    }
+
+    Arena & arena = program->get_arena();
+    program->set_root(arena.make<RootNode>(arena.make_array(functions), StatementsSequence()));
+
+    if (options.optimize)
+    {
+        Optimizer optimizer;
+        optimizer.optimize(program);
+    }
+
+    resolver.resolve_functions(program->get_root());
+    linker.link_functions(program->get_root());
+
+    if (!linker.can_bind_collected())
+    {
+        //statements are parsed once more to tell which calls fail
+        std::ifstream errors_fstream;
+        std::unique_ptr<IScanner> errors_scanner = open_scanner(options, errors_fstream);
+        Parser errors_parser(*errors_scanner);
+        ProgramPtr names(new Program());
+
+        errors_parser.start(names);
+        while (ASTNodePtr node = errors_parser.parse_next(statement_arena))
+        {
+            if (dynamic_cast<FunctionDefinitionNode *>(node) == nullptr)
+            {
+                linker.link_statement(node);
+            }
+            statement_arena.clear();
+        }
+    }
+
+    linker.check();
+
+    //memoization and spawned calls run pure functions differently
+    PurityAnalyzer analyzer;
+    analyzer.analyze(program->get_root());
+
+    if (options.optimize)
+    {
+        Specializer specializer;
+        specializer.specialize(program);
+    }
+
+    return program->get_root();
+}
+
+/*
+ * --stream: every top-level statement is run as soon as it's parsed and freed after,
+ * so memory holds the definitions and the largest statement rather than the program
+ */
+int run_stream(Options const & options)
+{
+    OutputBuffer output(STDOUT_FILENO, options.flush_policy);
+    InputReader input(STDIN_FILENO);
+    Interpreter interpreter(output, input);
+    ProgramPtr program(new Program());
+    Resolver resolver;
+    Linker linker;
+
+    interpreter.set_max_depth(options.max_depth);
+    interpreter.set_memoize(options.memoize);
+    interpreter.set_jit(options.jit, options.jit_log ? &std::cerr : nullptr);
+    interpreter.set_spawn_threads(options.spawn_threads);
+
+    try
+    {
+        RootNode * root = prescan_stream(options, program, resolver, linker);
+
+        size_t stack_size = options.max_depth * Interpreter::native_stack_per_call
+                            + 2 * Interpreter::native_stack_reserve;
+
+        run_on_native_stack(stack_size, [&options, &interpreter, &resolver, &linker, root]()
+        {
+            std::ifstream src_fstream;
+            std::unique_ptr<IScanner> scanner = open_scanner(options, src_fstream);
+            Parser parser(*scanner);
+            //names of the statements, their nodes are freed one by one
+            ProgramPtr names(new Program());
+            Arena statement_arena;
+            Optimizer optimizer;
+            Specializer specializer;
+
+            parser.start(names);
+            interpreter.begin(root);
+
+            for (ASTNodePtr node; (node = parser.parse_next(statement_arena)) != nullptr; statement_arena.clear())
+            {
+                if (dynamic_cast<FunctionDefinitionNode *>(node) != nullptr)
+                {
+                    continue;
+                }
+
+                if (options.optimize)
+                {
+                    optimizer.optimize_statement(node, statement_arena);
+                }
+
+                resolver.resolve_statement(node);
+                linker.link_statement(node);
+
+                if (options.optimize)
+                {
+                    node = specializer.specialize_statement(node, statement_arena);
+                }
+
+                if (!interpreter.execute_statement(node))
+                {
+                    break;
+                }
+            }
+
+            interpreter.end();
+        });
+    }
+    catch (LineNumberException &e)
+    {
+        output.flush();
+        print_error(e);
         return 1;
     }
+
     return 0;
 }
 
+/*
+ * --jobs: scripts of the command line, then the ones of the manifest
+ */
+int run_batch(Options const & options)
+{
+    std::vector<BatchScript> scripts;
+
+    for (std::string const & file : options.batch_files)
+    {
+        scripts.push_back(BatchScript{file, ""});
+    }
+
+    if (!options.manifest_file.empty() && !read_manifest(options.manifest_file, scripts))
+    {
+        std::cerr << "can't read manifest " << options.manifest_file << std::endl;
+        return 1;
+    }
+
+    pp::CompileOptions compile_options;
+    compile_options.optimize = options.optimize;
+
+    pp::RunOptions run_options;
+    run_options.max_depth = options.max_depth;
+    run_options.memoize = options.memoize;
+    run_options.jit = options.jit;
+
+    BatchRunner runner(options.jobs, compile_options, run_options);
+    return runner.run(scripts, std::cout, std::cerr) == 0 ? 0 : 1;
+}
+
+typedef std::chrono::steady_clock pp_clock;
+
+double seconds_since(pp_clock::time_point start)
+{
+    return std::chrono::duration<double>(pp_clock::now() - start).count();
+}
+
+int main(int argc, char const * argv[])
+{
+    Options options;
+
+    if (!parse_options(argc, argv, options))
+    {
+        display_usage();
+        return 1;
+    }
+
+    if (options.jobs != 0)
+    {
+        return run_batch(options);
+    }
+
+    std::ifstream src_fstream;
+    std::string source;
+    std::istringstream source_stream;
+    std::unique_ptr<IScanner> lexer;
+    bool parallel_parse = parse_in_parallel(options);
+
+    if (!options.cache_dir.empty() || parallel_parse)
+    {
+        //programs are cached by the source and parsed in parts from memory, so it's read once
+        if (read_source(options.source_file, source))
+        {
+            source_stream.str(source);
+            lexer.reset(new Lexer(source_stream));
+        }
+    }
+    else
+    {
+        lexer = open_scanner(options, src_fstream);
+    }
+
+    if (!lexer)
+    {
+        std::cerr << "can't open " << options.source_file << std::endl;
+        return 1;
+    }
+
+    if (options.stream)
+    {
+        return run_stream(options);
+    }
+
+    //counters are collected only with --stats, nothing is created otherwise
+    std::unique_ptr<Stats> stats;
+    std::unique_ptr<StatsInterpreter> stats_interpreter;
+    std::unique_ptr<ProfilingInterpreter> profiler;
+    std::unique_ptr<Interpreter> plain_interpreter;
+    Interpreter * interpreter = nullptr;
+    double lex_time = 0;
+    //names in the profile point into the program
+    ProgramPtr program;
+    std::unique_ptr<ProgramCache> cache;
+
+    if (options.stats)
+    {
+        stats.reset(new Stats());
+    }
+
+    if (!options.cache_dir.empty())
+    {
+        pp_clock::time_point start = pp_clock::now();
+        cache.reset(new ProgramCache(options.cache_dir));
+        program = cache->load(source);
+
+        if (stats)
+        {
+            stats->add_phase(program ? "load from cache" : "cache miss", seconds_since(start));
+        }
+    }
+
+    if (stats && !program)
+    {
+        //the parser pulls lexemes itself, so lexing is timed in a separate pass
+        std::ifstream lex_fstream;
+        std::istringstream lex_source_stream(source);
+        std::unique_ptr<IScanner> scanner;
+
+        if (cache)
+        {
+            scanner.reset(new Lexer(lex_source_stream));
+        }
+        else
+        {
+            scanner = open_scanner(options, lex_fstream);
+        }
+
+        lex_time = stats->lex(*scanner);
+        stats->add_phase("lex", lex_time);
+    }
+
+    Parser parser(*lexer);
+    OutputBuffer output(STDOUT_FILENO, options.flush_policy);
+    InputReader input(STDIN_FILENO);
+    int exit_code = 0;
+    pp_clock::time_point exec_start;
+
+    try
+    {
+        pp_clock::time_point start = pp_clock::now();
+
+        if (!program)
+        {
+            if (parallel_parse)
+            {
+                program = ParallelParser(source.data(), source.data() + source.size(), options.parse_jobs).parse();
+
+                if (stats)
+                {
+                    stats->add_phase("parse on " + std::to_string(options.parse_jobs) + " threads", seconds_since(start));
+                }
+            }
+            else
+            {
+                program = parser.parse();
+
+                if (stats)
+                {
+                    stats->add_phase("parse", std::max(0.0, seconds_since(start) - lex_time));
+                }
+            }
+
+            if (cache)
+            {
+                start = pp_clock::now();
+                cache->store(source, program);
+
+                if (stats)
+                {
+                    stats->add_phase("store in cache", seconds_since(start));
+                }
+            }
+        }
+
+        if (stats)
+        {
+            stats->count_nodes(program->get_root());
+        }
+
+        if (options.optimize)
+        {
+            start = pp_clock::now();
+            Optimizer optimizer;
+            optimizer.optimize(program);
+
+            if (stats)
+            {
+                stats->add_phase("optimize", seconds_since(start));
+            }
+        }
+
+        if (options.dump_ast)
+        {
+            ASTPrinter printer(std::cout);
+            printer.print(program->get_root());
+            return 0;
+        }
+
+        start = pp_clock::now();
+        Resolver resolver;
+        resolver.resolve(program);
+        ASTNodePtr root = program->get_root();
+
+        if (stats)
+        {
+            stats->add_phase("resolve", seconds_since(start));
+        }
+
+        start = pp_clock::now();
+        Linker linker;
+        linker.link(program);
+
+        if (stats)
+        {
+            stats->add_phase("link", seconds_since(start));
+        }
+
+        if (options.compile || !options.c_file.empty())
+        {
+            start = pp_clock::now();
+            exit_code = translate_to_c(options, root) ? 0 : 1;
+
+            if (stats)
+            {
+                stats->add_phase(options.compile ? "translate and compile C" : "translate to C", seconds_since(start));
+            }
+        }
+        else if (options.engine == Engine::VM)
+        {
+            start = pp_clock::now();
+            Compiler compiler;
+            BytecodeProgram bytecode = compiler.compile(root);
+
+            if (stats)
+            {
+                stats->add_phase("compile", seconds_since(start));
+            }
+
+            VM vm(bytecode, output, input);
+            vm.set_max_depth(options.max_depth);
+            exec_start = pp_clock::now();
+            vm.execute();
+        }
+        else
+        {
+            //every user call nests native calls, the stack is made as deep as --max-depth needs
+            size_t stack_size = options.max_depth * Interpreter::native_stack_per_call
+                                + 2 * Interpreter::native_stack_reserve;
+
+            //memoization and spawned calls run pure functions differently
+            start = pp_clock::now();
+            PurityAnalyzer analyzer;
+            analyzer.analyze(root);
+
+            if (stats)
+            {
+                stats->add_phase("purity analysis", seconds_since(start));
+            }
+
+            if (options.optimize)
+            {
+                start = pp_clock::now();
+                Specializer specializer;
+                specializer.specialize(program);
+
+                if (stats)
+                {
+                    stats->add_phase("specialize", seconds_since(start));
+                }
+            }
+
+            if (!options.profile_file.empty())
+            {
+                profiler.reset(new ProfilingInterpreter(output, input));
+                interpreter = profiler.get();
+            }
+            else if (stats)
+            {
+                stats_interpreter.reset(new StatsInterpreter(output, input));
+                interpreter = stats_interpreter.get();
+            }
+            else
+            {
+                plain_interpreter.reset(new Interpreter(output, input));
+                interpreter = plain_interpreter.get();
+                //counters and profiles are of a single thread
+                plain_interpreter->set_spawn_threads(options.spawn_threads);
+            }
+
+            interpreter->set_max_depth(options.max_depth);
+            interpreter->set_memoize(options.memoize);
+            interpreter->set_jit(options.jit, options.jit_log ? &std::cerr : nullptr);
+            exec_start = pp_clock::now();
+            run_on_native_stack(stack_size, [interpreter, root]() { interpreter->execute(root); });
+        }
+    }
+    catch (LineNumberException &e)
+    {
+        output.flush();
+        print_error(e);
+        exit_code = 1;
+    }
+
+    if (stats)
+    {
+        output.flush();
+
+        //execution time includes writing out the buffered output
+        if (exec_start != pp_clock::time_point())
+        {
+            stats->add_phase("execute", seconds_since(exec_start));
+        }
+
+        stats->report(std::cerr);
+
+        if (stats_interpreter)
+        {
+            stats_interpreter->report(std::cerr);
+        }
+        else if (options.engine == Engine::VM)
+        {
+            std::cerr << "  node visits, calls and variable lookups are counted by the tree engine only" << std::endl;
+        }
+    }
+
+    if (profiler)
+    {
+        output.flush();
+        std::ofstream profile_stream(options.profile_file);
+        profiler->write_folded(profile_stream);
+
+        if (!profile_stream)
+        {
+            std::cerr << "can't write " << options.profile_file << std::endl;
+            exit_code = 1;
+        }
+
+        profiler->report(std::cerr);
+    }
+
+    if (options.memoize_stats && interpreter != nullptr)
+    {
+        output.flush();
+        interpreter->report_memoization(std::cerr);
+    }
+
+    return exit_code;
+}
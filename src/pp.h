@@ -1,11 +1,23 @@
 #include <iostream>
+#include <cstdint>
 #include <exception>
 #include <string>
 
 #ifndef PP_H
 #define PP_H
 
-typedef int pp_value_t;
+//machine integer of the values, Value promotes the ones that don't fit
+typedef int64_t pp_value_t;
+
+//programs cached by another version are parsed again
+const char * const pp_version = "0.19";
+
+//hot paths the compiler would leave out of line as too long
+#if defined(__GNUC__)
+#define PP_ALWAYS_INLINE __attribute__((always_inline)) inline
+#else
+#define PP_ALWAYS_INLINE inline
+#endif
 
 #ifdef DEBUG
 #define dbg(a) std::cerr << a << std::endl;
@@ -0,0 +1,334 @@
+#include <atomic>
+#include <algorithm>
+#include <iomanip>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <sys/time.h>
+#include "profiler.h"
+
+static char const main_function[] = "<main>";
+
+//set by the timer, the only state the signal handler touches
+static std::atomic<unsigned> pending_samples(0);
+
+static void on_profiling_timer(int)
+{
+    pending_samples.fetch_add(1, std::memory_order_relaxed);
+}
+
+static uint64_t cpu_time_us()
+{
+    timespec time;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+
+    return static_cast<uint64_t>(time.tv_sec) * 1000000 + time.tv_nsec / 1000;
+}
+
+static void set_profiling_timer(long interval_us)
+{
+    itimerval timer;
+    timer.it_interval.tv_sec = interval_us / 1000000;
+    timer.it_interval.tv_usec = interval_us % 1000000;
+    timer.it_value = timer.it_interval;
+
+    setitimer(ITIMER_PROF, &timer, nullptr);
+}
+
+ProfilingInterpreter::ProfilingInterpreter(OutputBuffer & output, InputReader & input) :
+    Interpreter(output, input),
+    last_counters_(nullptr),
+    samples_(0),
+    total_time_(0),
+    last_sample_time_(0)
+{
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = on_profiling_timer;
+    //reads and writes carry on instead of failing with EINTR
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, nullptr);
+
+    pending_samples = 0;
+    //a reused frame would drop its caller from the sampled stacks
+    set_tail_calls(false);
+}
+
+ProfilingInterpreter::~ProfilingInterpreter()
+{
+    set_profiling_timer(0);
+    signal(SIGPROF, SIG_IGN);
+}
+
+void ProfilingInterpreter::execute(ASTNodePtr root)
+{
+    StringRef main_name(main_function, sizeof(main_function) - 1);
+    Counters * main_counters = &functions_[main_name];
+    main_counters->count++;
+    stack_.push_back({main_name, main_counters, 0});
+
+    last_sample_time_ = cpu_time_us();
+    set_profiling_timer(sample_interval_us);
+    Interpreter::execute(root);
+    set_profiling_timer(0);
+
+    take_sample();
+}
+
+void ProfilingInterpreter::poll_sample()
+{
+    if (pending_samples.load(std::memory_order_relaxed) > 0)
+    {
+        take_sample();
+    }
+}
+
+void ProfilingInterpreter::enter_statement(ASTNode const * node)
+{
+    size_t line = node->get_line_num();
+
+    if (line >= lines_.size())
+    {
+        lines_.resize(line + 1);
+    }
+
+    //time since the last sample point went to the previous line
+    poll_sample();
+
+    //the first statement of a call, its arguments are evaluated by now
+    if (stack_.size() <= get_depth())
+    {
+        stack_.push_back(pending_calls_.back());
+        pending_calls_.pop_back();
+    }
+
+    LineCounters & counters = lines_[line];
+    if (counters.count++ == 0)
+    {
+        counters.function = stack_.back().function;
+    }
+
+    stack_.back().line = line;
+}
+
+void ProfilingInterpreter::take_sample()
+{
+    pending_samples.store(0, std::memory_order_relaxed);
+
+    //signals may be coalesced, so the sample weighs the CPU time since the last one
+    uint64_t now = cpu_time_us();
+    uint64_t weight = now - last_sample_time_;
+    last_sample_time_ = now;
+
+    samples_++;
+    total_time_ += weight;
+    std::string stack;
+
+    for (Frame const & frame : stack_)
+    {
+        if (frame.line >= lines_.size())
+        {
+            lines_.resize(frame.line + 1);
+        }
+    }
+
+    //deep recursion keeps the outermost and the innermost frames of the stack
+    size_t elided_from = stack_.size();
+    size_t elided_to = stack_.size();
+    if (stack_.size() > max_folded_frames)
+    {
+        elided_from = max_folded_frames / 2;
+        elided_to = stack_.size() - max_folded_frames / 2;
+    }
+
+    for (size_t i = 0; i < stack_.size(); i++)
+    {
+        Frame const & frame = stack_[i];
+
+        if (i < elided_from || i >= elided_to)
+        {
+            if (!stack.empty())
+            {
+                stack += ';';
+            }
+            stack += frame.function.str() + ":" + std::to_string(frame.line);
+        }
+        else if (i == elided_from)
+        {
+            stack += ";...";
+        }
+
+        Counters & line = lines_[frame.line];
+        if (line.last_sample != samples_)
+        {
+            line.last_sample = samples_;
+            line.cumulative += weight;
+        }
+
+        if (frame.counters->last_sample != samples_)
+        {
+            frame.counters->last_sample = samples_;
+            frame.counters->cumulative += weight;
+        }
+    }
+
+    folded_[stack] += weight;
+    lines_[stack_.back().line].self += weight;
+    stack_.back().counters->self += weight;
+}
+
+void ProfilingInterpreter::visit(AssignmentNode * node)
+{
+    enter_statement(node);
+    Interpreter::visit(node);
+}
+
+void ProfilingInterpreter::visit(FunctionCallNode * node)
+{
+    if (node->is_statement())
+    {
+        enter_statement(node);
+    }
+
+    //recursion and loops mostly call the same function again
+    StringRef name = node->get_name();
+    if (name.data() != last_called_.data() || name.size() != last_called_.size())
+    {
+        last_called_ = name;
+        last_counters_ = &functions_[name];
+    }
+
+    Counters * counters = last_counters_;
+    counters->count++;
+
+    //the callee frame becomes current with its first statement
+    size_t pending_calls = pending_calls_.size();
+    pending_calls_.push_back({name, counters, node->get_line_num()});
+    Interpreter::visit(node);
+    poll_sample();
+
+    if (pending_calls_.size() > pending_calls)
+    {
+        //the function has no statements
+        pending_calls_.pop_back();
+    }
+    else
+    {
+        stack_.pop_back();
+    }
+}
+
+void ProfilingInterpreter::visit(IfStatementNode * node)
+{
+    enter_statement(node);
+    Interpreter::visit(node);
+}
+
+void ProfilingInterpreter::visit(WhileStatementNode * node)
+{
+    enter_statement(node);
+    Interpreter::visit(node);
+}
+
+void ProfilingInterpreter::visit(PrintNode * node)
+{
+    enter_statement(node);
+    Interpreter::visit(node);
+}
+
+void ProfilingInterpreter::visit(ReadNode * node)
+{
+    enter_statement(node);
+    Interpreter::visit(node);
+}
+
+void ProfilingInterpreter::visit(ReturnNode * node)
+{
+    enter_statement(node);
+    Interpreter::visit(node);
+}
+
+void ProfilingInterpreter::write_folded(std::ostream & os) const
+{
+    std::vector<std::pair<std::string, size_t>> stacks(folded_.begin(), folded_.end());
+    std::sort(stacks.begin(), stacks.end());
+
+    for (auto const & stack : stacks)
+    {
+        if (stack.second > 0)
+        {
+            os << stack.first << " " << stack.second << "\n";
+        }
+    }
+}
+
+static double to_ms(uint64_t time_us)
+{
+    return time_us / 1000.0;
+}
+
+void ProfilingInterpreter::report(std::ostream & os) const
+{
+    std::vector<size_t> lines;
+    for (size_t line = 0; line < lines_.size(); line++)
+    {
+        if (lines_[line].count > 0)
+        {
+            lines.push_back(line);
+        }
+    }
+
+    //by self time, then by executions
+    std::sort(lines.begin(), lines.end(), [this](size_t a, size_t b) {
+        if (lines_[a].self != lines_[b].self)
+        {
+            return lines_[a].self > lines_[b].self;
+        }
+        if (lines_[a].count != lines_[b].count)
+        {
+            return lines_[a].count > lines_[b].count;
+        }
+
+        return a < b;
+    });
+
+    std::vector<std::pair<StringRef, Counters>> functions(functions_.begin(), functions_.end());
+    std::sort(functions.begin(), functions.end(), [](std::pair<StringRef, Counters> const & a,
+                                                     std::pair<StringRef, Counters> const & b) {
+        if (a.second.self != b.second.self)
+        {
+            return a.second.self > b.second.self;
+        }
+        if (a.second.count != b.second.count)
+        {
+            return a.second.count > b.second.count;
+        }
+
+        return a.first.str() < b.first.str();
+    });
+
+    os << "profile: " << samples_ << " samples, " << to_ms(total_time_) << " ms of CPU time" << std::endl;
+    os << std::fixed << std::setprecision(1);
+
+    os << std::endl << std::setw(8) << "line" << "  " << std::left << std::setw(20) << "function" << std::right
+       << std::setw(14) << "executions" << std::setw(12) << "self ms" << std::setw(14) << "cumul. ms" << std::endl;
+
+    for (size_t line : lines)
+    {
+        LineCounters const & counters = lines_[line];
+        os << std::setw(8) << line << "  " << std::left << std::setw(20) << counters.function.str() << std::right
+           << std::setw(14) << counters.count << std::setw(12) << to_ms(counters.self)
+           << std::setw(14) << to_ms(counters.cumulative) << std::endl;
+    }
+
+    os << std::endl << std::left << std::setw(30) << "function" << std::right
+       << std::setw(14) << "calls" << std::setw(12) << "self ms" << std::setw(14) << "cumul. ms" << std::endl;
+
+    for (auto const & function : functions)
+    {
+        os << std::left << std::setw(30) << function.first.str() << std::right
+           << std::setw(14) << function.second.count << std::setw(12) << to_ms(function.second.self)
+           << std::setw(14) << to_ms(function.second.cumulative) << std::endl;
+    }
+}
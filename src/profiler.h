@@ -0,0 +1,105 @@
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "pp.h"
+#include "ast.h"
+#include "interpreter.h"
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/*
+ * Interpreter profiling the program per source line and per function.
+ * Executions and calls are counted exactly, time is sampled: a CPU time
+ * timer raises a flag every sample_interval_us and the sample is taken
+ * at the next statement or return from the stack of function frames
+ * and weighs the CPU time since the previous one.
+ * Self time of a line or function is the time it was on the top
+ * of the stack, cumulative time is the time it was anywhere in the stack.
+ * Only one profiler may run at a time
+ */
+class ProfilingInterpreter : public Interpreter
+{
+    public:
+        static const long sample_interval_us = 1000;
+        //deeper folded stacks elide their middle frames as "..."
+        static const size_t max_folded_frames = 128;
+
+        ProfilingInterpreter(OutputBuffer & output, InputReader & input);
+        ~ProfilingInterpreter();
+
+        virtual void execute(ASTNodePtr root) override;
+
+        /*
+         * one line per distinct stack: frames from the outermost one
+         * as function:line separated by ';', then microseconds of CPU time
+         */
+        void write_folded(std::ostream & os) const;
+
+        /*
+         * lines and functions sorted by self time
+         */
+        void report(std::ostream & os) const;
+
+        virtual void visit(AssignmentNode * node) override;
+        virtual void visit(FunctionCallNode * node) override;
+        virtual void visit(IfStatementNode * node) override;
+        virtual void visit(WhileStatementNode * node) override;
+        virtual void visit(PrintNode * node) override;
+        virtual void visit(ReadNode * node) override;
+        virtual void visit(ReturnNode * node) override;
+
+        //statements of specialized kinds are profiled as the generic ones
+        virtual void visit(CompareIfNode * node) override { visit(static_cast<IfStatementNode *>(node)); }
+        virtual void visit(CompareWhileNode * node) override { visit(static_cast<WhileStatementNode *>(node)); }
+        virtual void visit(IncrementNode * node) override { visit(static_cast<AssignmentNode *>(node)); }
+
+        ProfilingInterpreter &operator=(ProfilingInterpreter const &a) = delete;
+        ProfilingInterpreter(ProfilingInterpreter const &a) = delete;
+
+    private:
+        struct Counters
+        {
+            Counters() : count(0), self(0), cumulative(0), last_sample(0) {}
+
+            size_t count;
+            //microseconds of CPU time
+            uint64_t self;
+            uint64_t cumulative;
+            //the sample that last added to cumulative, recursion adds once
+            size_t last_sample;
+        };
+
+        struct LineCounters : Counters
+        {
+            StringRef function;
+        };
+
+
+        struct Frame
+        {
+            StringRef function;
+            Counters * counters;
+            size_t line;
+        };
+
+        void enter_statement(ASTNode const * node);
+        void poll_sample();
+        void take_sample();
+
+        std::vector<Frame> stack_;
+        //calls evaluating their arguments
+        std::vector<Frame> pending_calls_;
+        std::vector<LineCounters> lines_;
+        std::unordered_map<StringRef, Counters, StringRefHash> functions_;
+        std::unordered_map<std::string, size_t> folded_;
+        StringRef last_called_;
+        Counters * last_counters_;
+        size_t samples_;
+        uint64_t total_time_;
+        uint64_t last_sample_time_;
+};
+
+#endif //PROFILER_H
@@ -0,0 +1,526 @@
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include "program_cache.h"
+
+static const char magic[] = {'p', 'p', 'c', '\n'};
+
+enum class NodeTag : uint8_t
+{
+    FUNCTION_DEFINITION, ASSIGNMENT, FUNCTION_CALL, IF, WHILE, PRINT, 
+    READ, RETURN, VARIABLE, LITERAL, UNARY_MINUS, BINARY_OPERATOR,
+    SPAWN, SYNC
+};
+
+class CorruptEntryException : public std::exception
+{
+};
+
+/*
+ * FNV-1a
+ */
+static uint64_t hash_bytes(char const * data, size_t size)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+    }
+
+    return hash;
+}
+
+static void write_varint(std::string & out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+static void write_u64(std::string & out, uint64_t value)
+{
+    for (size_t i = 0; i < 8; i++)
+    {
+        out.push_back(static_cast<char>(value >> 8 * i));
+    }
+}
+
+/*
+ * Builds the program back in its arena, every read is checked
+ * against the end of the data
+ */
+class ProgramReader
+{
+    public:
+        ProgramReader(char const * begin, char const * end, Arena & arena) :
+            position_(begin),
+            end_(end),
+            arena_(arena)
+        {}
+
+        RootNode * read_root();
+
+    private:
+        uint8_t read_byte()
+        {
+            if (position_ == end_)
+            {
+                throw CorruptEntryException();
+            }
+
+            return *position_++;
+        }
+
+        uint64_t read_varint()
+        {
+            uint64_t value = 0;
+            for (size_t shift = 0; shift < 64; shift += 7)
+            {
+                uint8_t byte = read_byte();
+                value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+
+                if ((byte & 0x80) == 0)
+                {
+                    return value;
+                }
+            }
+
+            throw CorruptEntryException();
+        }
+
+        /*
+         * a count of things taking a byte at least
+         */
+        size_t read_count()
+        {
+            uint64_t count = read_varint();
+            if (count > static_cast<uint64_t>(end_ - position_))
+            {
+                throw CorruptEntryException();
+            }
+
+            return count;
+        }
+
+        StringRef read_name()
+        {
+            uint64_t index = read_varint();
+            if (index >= names_.size())
+            {
+                throw CorruptEntryException();
+            }
+
+            return names_[index];
+        }
+
+        template<class T, class... Args>
+        T * make(size_t line, Args &&... args)
+        {
+            T * node = arena_.make<T>(std::forward<Args>(args)...);
+            node->set_line_num(line);
+            return node;
+        }
+
+        StatementsSequence read_sequence();
+        ASTNodePtr read_node();
+        ASTNodePtr read_inner_node();
+
+        char const * position_;
+        char const * end_;
+        Arena & arena_;
+        std::vector<StringRef> names_;
+};
+
+RootNode * ProgramReader::read_root()
+{
+    size_t names_num = read_count();
+    for (size_t i = 0; i < names_num; i++)
+    {
+        size_t size = read_count();
+        names_.push_back(arena_.make_string(std::string(position_, size)));
+        position_ += size;
+    }
+
+    std::vector<ASTNodePtr> functions(read_count());
+    for (ASTNodePtr & function : functions)
+    {
+        function = read_node();
+        if (dynamic_cast<FunctionDefinitionNode *>(function) == nullptr)
+        {
+            throw CorruptEntryException();
+        }
+    }
+
+    StatementsSequence statements = read_sequence();
+    if (position_ != end_)
+    {
+        throw CorruptEntryException();
+    }
+
+    return arena_.make<RootNode>(arena_.make_array(functions), statements);
+}
+
+StatementsSequence ProgramReader::read_sequence()
+{
+    std::vector<ASTNodePtr> statements(read_count());
+    for (ASTNodePtr & statement : statements)
+    {
+        statement = read_inner_node();
+    }
+
+    return arena_.make_array(statements);
+}
+
+/*
+ * functions are defined at the top level only
+ */
+ASTNodePtr ProgramReader::read_inner_node()
+{
+    ASTNodePtr node = read_node();
+    if (dynamic_cast<FunctionDefinitionNode *>(node) != nullptr)
+    {
+        throw CorruptEntryException();
+    }
+
+    return node;
+}
+
+ASTNodePtr ProgramReader::read_node()
+{
+    NodeTag tag = static_cast<NodeTag>(read_byte());
+    size_t line = read_varint();
+
+    switch (tag)
+    {
+        case NodeTag::FUNCTION_DEFINITION:
+        {
+            StringRef name = read_name();
+            std::vector<StringRef> params(read_count());
+            for (StringRef & param : params)
+            {
+                param = read_name();
+            }
+
+            StatementsSequence statements = read_sequence();
+            return make<FunctionDefinitionNode>(line, name, arena_.make_array(params), statements);
+        }
+        case NodeTag::ASSIGNMENT:
+        {
+            StringRef name = read_name();
+            return make<AssignmentNode>(line, name, read_inner_node());
+        }
+        case NodeTag::FUNCTION_CALL:
+        {
+            StringRef name = read_name();
+            bool is_statement = read_byte() != 0;
+            FunctionCallNode * call = make<FunctionCallNode>(line, name, read_sequence());
+            call->set_statement(is_statement);
+            return call;
+        }
+        case NodeTag::IF:
+        {
+            ASTNodePtr expr = read_inner_node();
+            return make<IfStatementNode>(line, expr, read_sequence());
+        }
+        case NodeTag::WHILE:
+        {
+            ASTNodePtr expr = read_inner_node();
+            return make<WhileStatementNode>(line, expr, read_sequence());
+        }
+        case NodeTag::PRINT:
+            return make<PrintNode>(line, read_inner_node());
+        case NodeTag::READ:
+            return make<ReadNode>(line, read_name());
+        case NodeTag::RETURN:
+            return make<ReturnNode>(line, read_inner_node());
+        case NodeTag::VARIABLE:
+            return make<VariableNode>(line, read_name());
+        case NodeTag::LITERAL:
+        {
+            //zigzag encoded
+            uint64_t value = read_varint();
+            return make<LiteralNode>(line, static_cast<pp_value_t>((value >> 1) ^ (0 - (value & 1))));
+        }
+        case NodeTag::UNARY_MINUS:
+            return make<UnaryMinusNode>(line, read_inner_node());
+        case NodeTag::BINARY_OPERATOR:
+        {
+            uint8_t type = read_byte();
+            if (type > static_cast<uint8_t>(BinaryOperatorType::LESS_OR_EQALS))
+            {
+                throw CorruptEntryException();
+            }
+
+            ASTNodePtr first_expr = read_inner_node();
+            ASTNodePtr second_expr = read_inner_node();
+            return make<BinaryOperatorNode>(line, static_cast<BinaryOperatorType>(type), first_expr, second_expr);
+        }
+        case NodeTag::SPAWN:
+        {
+            StringRef name = read_name();
+            FunctionCallNode * call = dynamic_cast<FunctionCallNode *>(read_inner_node());
+            if (call == nullptr)
+            {
+                throw CorruptEntryException();
+            }
+
+            return make<SpawnNode>(line, name, call);
+        }
+        case NodeTag::SYNC:
+            return make<SyncNode>(line);
+    }
+
+    throw CorruptEntryException();
+}
+
+void ProgramWriter::write(ProgramPtr program)
+{
+    nodes_.clear();
+    names_.clear();
+    names_order_.clear();
+    program->get_root()->accept(this);
+
+    write_varint(out_, names_order_.size());
+    for (StringRef name : names_order_)
+    {
+        write_varint(out_, name.size());
+        out_.append(name.data(), name.size());
+    }
+    out_ += nodes_;
+}
+
+void ProgramWriter::write_node(uint8_t tag, ASTNode const * node)
+{
+    nodes_.push_back(static_cast<char>(tag));
+    write_varint(nodes_, node->get_line_num());
+}
+
+void ProgramWriter::write_sequence(StatementsSequence const & statements)
+{
+    write_varint(nodes_, statements.size());
+    for (ASTNodePtr const & statement : statements)
+    {
+        statement->accept(this);
+    }
+}
+
+void ProgramWriter::write_name(StringRef name)
+{
+    auto it = names_.find(name);
+    if (it == names_.end())
+    {
+        it = names_.emplace(name, names_order_.size()).first;
+        names_order_.push_back(name);
+    }
+
+    write_varint(nodes_, it->second);
+}
+
+void ProgramWriter::visit(RootNode * node)
+{
+    write_sequence(node->get_functions());
+    write_sequence(node->get_statements());
+}
+
+void ProgramWriter::visit(FunctionDefinitionNode * node)
+{
+    write_node(static_cast<uint8_t>(NodeTag::FUNCTION_DEFINITION), node);
+    write_name(node->get_name());
+
+    write_varint(nodes_, node->get_params().size());
+    for (StringRef param : node->get_params())
+    {
+        write_name(param);
+    }
+
+    write_sequence(node->get_statements());
+}
+
+void ProgramWriter::visit(AssignmentNode * node)
+{
+    write_node(static_cast<uint8_t>(NodeTag::ASSIGNMENT), node);
+    write_name(node->get_var_name());
+    node->get_expr()->accept(this);
+}
+
+void ProgramWriter::visit(SpawnNode * node)
+{
+    write_node(static_cast<uint8_t>(NodeTag::SPAWN), node);
+    write_name(node->get_var_name());
+    node->get_call()->accept(this);
+}
+
+void ProgramWriter::visit(SyncNode * node)
+{
+    write_node(static_cast<uint8_t>(NodeTag::SYNC), node);
+}
+
+void ProgramWriter::visit(FunctionCallNode * node)
+{
+    write_node(static_cast<uint8_t>(NodeTag::FUNCTION_CALL), node);
+    write_name(node->get_name());
+    nodes_.push_back(node->is_statement() ? 1 : 0);
+    write_sequence(node->get_params());
+}
+
+void ProgramWriter::visit(IfStatementNode * node)
+{
+    write_node(static_cast<uint8_t>(NodeTag::IF), node);
+    node->get_expr()->accept(this);
+    write_sequence(node->get_statements());
+}
+
+void ProgramWriter::visit(WhileStatementNode * node)
+{
+    write_node(static_cast<uint8_t>(NodeTag::WHILE), node);
+    node->get_expr()->accept(this);
+    write_sequence(node->get_statements());
+}
+
+void ProgramWriter::visit(PrintNode * node)
+{
+    write_node(static_cast<uint8_t>(NodeTag::PRINT), node);
+    node->get_expr()->accept(this);
+}
+
+void ProgramWriter::visit(ReadNode * node)
+{
+    write_node(static_cast<uint8_t>(NodeTag::READ), node);
+    write_name(node->get_var_name());
+}
+
+void ProgramWriter::visit(ReturnNode * node)
+{
+    write_node(static_cast<uint8_t>(NodeTag::RETURN), node);
+    node->get_expr()->accept(this);
+}
+
+void ProgramWriter::visit(VariableNode * node)
+{
+    write_node(static_cast<uint8_t>(NodeTag::VARIABLE), node);
+    write_name(node->get_var_name());
+}
+
+void ProgramWriter::visit(LiteralNode * node)
+{
+    write_node(static_cast<uint8_t>(NodeTag::LITERAL), node);
+
+    uint64_t value = static_cast<uint64_t>(node->get_value());
+    write_varint(nodes_, (value << 1) ^ (0 - (value >> 63)));
+}
+
+void ProgramWriter::visit(UnaryMinusNode * node)
+{
+    write_node(static_cast<uint8_t>(NodeTag::UNARY_MINUS), node);
+    node->get_expr()->accept(this);
+}
+
+void ProgramWriter::visit(BinaryOperatorNode * node)
+{
+    write_node(static_cast<uint8_t>(NodeTag::BINARY_OPERATOR), node);
+    nodes_.push_back(static_cast<char>(node->get_type()));
+    node->get_first_expr()->accept(this);
+    node->get_second_expr()->accept(this);
+}
+
+/*
+ * everything an entry must match: format, interpreter version and the source
+ */
+std::string ProgramCache::header(std::string const & source) const
+{
+    std::string header(magic, sizeof(magic));
+    write_varint(header, format_version);
+    write_varint(header, std::string(pp_version).size());
+    header += pp_version;
+    write_varint(header, source.size());
+    write_u64(header, hash_bytes(source.data(), source.size()));
+
+    return header;
+}
+
+std::string ProgramCache::entry_path(std::string const & source) const
+{
+    std::string key = header(source);
+    std::ostringstream path;
+    path << dir_ << "/" << std::hex << std::setw(16) << std::setfill('0') << hash_bytes(key.data(), key.size()) << ".ppc";
+
+    return path.str();
+}
+
+ProgramPtr ProgramCache::load(std::string const & source) const
+{
+    std::ifstream file(entry_path(source), std::ios::in | std::ios::binary);
+    if (!file)
+    {
+        return nullptr;
+    }
+
+    std::string entry((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::string expected_header = header(source);
+
+    //header, checksum of the payload, payload
+    if (entry.size() < expected_header.size() + 8 || entry.compare(0, expected_header.size(), expected_header) != 0)
+    {
+        return nullptr;
+    }
+
+    try
+    {
+        ProgramPtr program(new Program());
+        char const * position = entry.data() + expected_header.size();
+        char const * end = entry.data() + entry.size();
+
+        uint64_t checksum = 0;
+        for (size_t i = 0; i < 8; i++)
+        {
+            checksum |= static_cast<uint64_t>(static_cast<unsigned char>(position[i])) << 8 * i;
+        }
+        position += 8;
+
+        if (hash_bytes(position, end - position) != checksum)
+        {
+            return nullptr;
+        }
+
+        ProgramReader reader(position, end, program->get_arena());
+        program->set_root(reader.read_root());
+
+        return program;
+    }
+    catch (CorruptEntryException const &)
+    {
+        return nullptr;
+    }
+}
+
+void ProgramCache::store(std::string const & source, ProgramPtr program) const
+{
+    std::string payload;
+    ProgramWriter writer(payload);
+    writer.write(program);
+
+    std::string entry = header(source);
+    write_u64(entry, hash_bytes(payload.data(), payload.size()));
+    entry += payload;
+
+    //the entry appears complete or not at all, concurrent runs may store the same one
+    mkdir(dir_.c_str(), 0777);
+    std::string path = entry_path(source);
+    std::string temporary = path + ".tmp" + std::to_string(getpid());
+
+    std::ofstream file(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+    file.write(entry.data(), entry.size());
+    file.close();
+
+    if (!file || std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+    }
+}
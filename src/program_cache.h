@@ -0,0 +1,82 @@
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "pp.h"
+#include "ast.h"
+#include "ast_visitor.h"
+#include "string_ref.h"
+
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+/*
+ * Writes the parsed program in a compact binary form: names once in a table,
+ * then the nodes in preorder as a tag, a line and the fields, all numbers
+ * as variable-length integers
+ */
+class ProgramWriter : public ASTNodeVisitor
+{
+    public:
+        ProgramWriter(std::string & out) : out_(out) {}
+
+        void write(ProgramPtr program);
+
+        virtual void visit(RootNode * node) override;
+        virtual void visit(FunctionDefinitionNode * node) override;
+        virtual void visit(AssignmentNode * node) override;
+        virtual void visit(FunctionCallNode * node) override;
+        virtual void visit(IfStatementNode * node) override;
+        virtual void visit(WhileStatementNode * node) override;
+        virtual void visit(PrintNode * node) override;
+        virtual void visit(ReadNode * node) override;
+        virtual void visit(ReturnNode * node) override;
+        virtual void visit(VariableNode * node) override;
+        virtual void visit(LiteralNode * node) override;
+        virtual void visit(UnaryMinusNode * node) override;
+        virtual void visit(BinaryOperatorNode * node) override;
+
+        virtual void visit(SpawnNode * node) override;
+        virtual void visit(SyncNode * node) override;
+
+    private:
+        void write_node(uint8_t tag, ASTNode const * node);
+        void write_sequence(StatementsSequence const & statements);
+        void write_name(StringRef name);
+
+        std::string & out_;
+        std::string nodes_;
+        std::unordered_map<StringRef, size_t, StringRefHash> names_;
+        std::vector<StringRef> names_order_;
+};
+
+/*
+ * Parsed programs stored in files of a directory, named by a hash of
+ * the interpreter version and the source. Every entry repeats the key and carries
+ * a checksum, so stale and corrupt entries are detected and just rebuilt
+ */
+class ProgramCache
+{
+    public:
+        static const uint32_t format_version = 3;
+
+        ProgramCache(std::string const & dir) : dir_(dir) {}
+
+        /*
+         * returns nullptr if there is no usable entry for the source
+         */
+        ProgramPtr load(std::string const & source) const;
+
+        /*
+         * failures are ignored, the program is parsed again next time
+         */
+        void store(std::string const & source, ProgramPtr program) const;
+
+    private:
+        std::string entry_path(std::string const & source) const;
+        std::string header(std::string const & source) const;
+
+        std::string dir_;
+};
+
+#endif //PROGRAM_CACHE_H
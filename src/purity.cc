@@ -0,0 +1,147 @@
+#include "purity.h"
+
+size_t PurityAnalyzer::analyze(ASTNodePtr root)
+{
+    functions_.clear();
+    root->accept(this);
+
+    while (propagate())
+    {
+    }
+
+    size_t pure_num = 0;
+    for (auto & function : functions_)
+    {
+        function.second.node->set_pure(function.second.pure);
+        pure_num += function.second.pure;
+    }
+
+    return pure_num;
+}
+
+/*
+ * a call of an impure function makes the caller impure,
+ * returns true if any function became impure
+ */
+bool PurityAnalyzer::propagate()
+{
+    bool changed = false;
+
+    for (auto & function : functions_)
+    {
+        if (!function.second.pure)
+        {
+            continue;
+        }
+
+        for (FunctionCallNode const * call : function.second.calls)
+        {
+            auto callee = functions_.find(call->get_name());
+
+            if (callee == functions_.end() || !callee->second.pure
+                || callee->second.node->get_params().size() != call->get_params().size())
+            {
+                function.second.pure = false;
+                changed = true;
+                break;
+            }
+        }
+    }
+
+    return changed;
+}
+
+void PurityAnalyzer::visit_sequence(StatementsSequence const & statements)
+{
+    for (ASTNodePtr const & statement : statements)
+    {
+        statement->accept(this);
+    }
+}
+
+void PurityAnalyzer::visit(RootNode * node)
+{
+    //top level statements aren't a function, only calls made from them are cached
+    for (ASTNodePtr const & function : node->get_functions())
+    {
+        function->accept(this);
+    }
+}
+
+void PurityAnalyzer::visit(FunctionDefinitionNode * node)
+{
+    //a later definition replaces the earlier one
+    node->set_pure(false);
+    current_ = &functions_[node->get_name()];
+
+    if (current_->node != nullptr)
+    {
+        *current_ = Function();
+    }
+
+    current_->node = node;
+    visit_sequence(node->get_statements());
+}
+
+void PurityAnalyzer::visit(AssignmentNode * node)
+{
+    //assignments within functions are always local
+    node->get_expr()->accept(this);
+}
+
+void PurityAnalyzer::visit(FunctionCallNode * node)
+{
+    current_->calls.push_back(node);
+    visit_sequence(node->get_params());
+}
+
+void PurityAnalyzer::visit(IfStatementNode * node)
+{
+    node->get_expr()->accept(this);
+    visit_sequence(node->get_statements());
+}
+
+void PurityAnalyzer::visit(WhileStatementNode * node)
+{
+    node->get_expr()->accept(this);
+    visit_sequence(node->get_statements());
+}
+
+void PurityAnalyzer::visit(PrintNode *)
+{
+    current_->pure = false;
+}
+
+void PurityAnalyzer::visit(ReadNode *)
+{
+    current_->pure = false;
+}
+
+void PurityAnalyzer::visit(ReturnNode * node)
+{
+    node->get_expr()->accept(this);
+}
+
+void PurityAnalyzer::visit(VariableNode * node)
+{
+    //a local that isn't assigned yet is read from globals
+    if (node->get_global_slot() != no_slot)
+    {
+        current_->pure = false;
+    }
+}
+
+void PurityAnalyzer::visit(LiteralNode *)
+{
+}
+
+void PurityAnalyzer::visit(UnaryMinusNode * node)
+{
+    node->get_expr()->accept(this);
+}
+
+void PurityAnalyzer::visit(BinaryOperatorNode * node)
+{
+    node->get_first_expr()->accept(this);
+    node->get_second_expr()->accept(this);
+}
@@ -0,0 +1,57 @@
+#include <vector>
+#include <unordered_map>
+#include "pp.h"
+#include "ast.h"
+#include "ast_visitor.h"
+
+#ifndef PURITY_H
+#define PURITY_H
+
+/*
+ * Marks functions whose result depends on the arguments only:
+ * they neither print nor read, never read a global variable
+ * and call only pure functions with the right number of arguments.
+ * Must be run after Resolver, which tells locals from globals
+ */
+class PurityAnalyzer : public ASTNodeVisitor
+{
+    public:
+        PurityAnalyzer() : current_(nullptr) {}
+
+        /*
+         * returns the number of pure functions
+         */
+        size_t analyze(ASTNodePtr root);
+
+        virtual void visit(RootNode * node) override;
+        virtual void visit(FunctionDefinitionNode * node) override;
+        virtual void visit(AssignmentNode * node) override;
+        virtual void visit(FunctionCallNode * node) override;
+        virtual void visit(IfStatementNode * node) override;
+        virtual void visit(WhileStatementNode * node) override;
+        virtual void visit(PrintNode * node) override;
+        virtual void visit(ReadNode * node) override;
+        virtual void visit(ReturnNode * node) override;
+        virtual void visit(VariableNode * node) override;
+        virtual void visit(LiteralNode * node) override;
+        virtual void visit(UnaryMinusNode * node) override;
+        virtual void visit(BinaryOperatorNode * node) override;
+
+    private:
+        struct Function
+        {
+            Function() : node(nullptr), pure(true) {}
+
+            FunctionDefinitionNode * node;
+            bool pure;
+            std::vector<FunctionCallNode const *> calls;
+        };
+
+        void visit_sequence(StatementsSequence const & statements);
+        bool propagate();
+
+        std::unordered_map<StringRef, Function, StringRefHash> functions_;
+        Function * current_;
+};
+
+#endif //PURITY_H
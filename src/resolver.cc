@@ -0,0 +1,181 @@
+#include "resolver.h"
+
+void Resolver::resolve(ProgramPtr program)
+{
+    arena_ = &program->get_arena();
+    program->get_root()->accept(this);
+}
+
+void Resolver::start(ProgramPtr program)
+{
+    arena_ = &program->get_arena();
+    locals_.clear();
+    slot_names_.clear();
+}
+
+void Resolver::collect_globals(ASTNodePtr statement)
+{
+    within_function_ = false;
+    collecting_ = true;
+    statement->accept(this);
+}
+
+void Resolver::resolve_functions(RootNode * root)
+{
+    root->set_slot_names(arena_->make_array(slot_names_));
+    globals_ = locals_;
+
+    within_function_ = true;
+    for (ASTNodePtr const & function : root->get_functions())
+    {
+        function->accept(this);
+    }
+
+    locals_ = globals_;
+}
+
+void Resolver::resolve_statement(ASTNodePtr statement)
+{
+    within_function_ = false;
+    collecting_ = false;
+    statement->accept(this);
+}
+
+void Resolver::visit(RootNode * node)
+{
+    within_function_ = false;
+    node->set_slot_names(resolve_frame(node->get_statements(), NamesSequence()));
+    globals_ = locals_;
+
+    within_function_ = true;
+    for (ASTNodePtr const & function : node->get_functions())
+    {
+        function->accept(this);
+    }
+}
+
+void Resolver::visit(FunctionDefinitionNode * node)
+{
+    node->set_slot_names(resolve_frame(node->get_statements(), node->get_params()));
+}
+
+/*
+ * Slots are known only when the whole body is seen as a variable
+ * may be read before the assignment, so it takes two passes
+ */
+NamesSequence Resolver::resolve_frame(StatementsSequence const & statements, NamesSequence const & params)
+{
+    locals_.clear();
+    slot_names_.clear();
+
+    for (StringRef param : params)
+    {
+        add_variable(param);
+    }
+
+    collecting_ = true;
+    visit_sequence(statements);
+
+    collecting_ = false;
+    visit_sequence(statements);
+
+    return arena_->make_array(slot_names_);
+}
+
+void Resolver::visit_sequence(StatementsSequence const & statements)
+{
+    for (ASTNodePtr const & statement : statements)
+    {
+        statement->accept(this);
+    }
+}
+
+int Resolver::add_variable(StringRef name)
+{
+    auto it = locals_.find(name.str());
+    if (it != locals_.end())
+    {
+        return it->second;
+    }
+
+    int slot = slot_names_.size();
+    locals_[name.str()] = slot;
+    slot_names_.push_back(name);
+
+    return slot;
+}
+
+void Resolver::visit(AssignmentNode * node)
+{
+    node->get_expr()->accept(this);
+    node->set_slot(add_variable(node->get_var_name()));
+}
+
+void Resolver::visit(FunctionCallNode * node)
+{
+    for (ASTNodePtr const & param : node->get_params())
+    {
+        param->accept(this);
+    }
+}
+
+void Resolver::visit(IfStatementNode * node)
+{
+    node->get_expr()->accept(this);
+    visit_sequence(node->get_statements());
+}
+
+void Resolver::visit(WhileStatementNode * node)
+{
+    node->get_expr()->accept(this);
+    visit_sequence(node->get_statements());
+}
+
+void Resolver::visit(PrintNode * node)
+{
+    node->get_expr()->accept(this);
+}
+
+void Resolver::visit(ReadNode * node)
+{
+    node->set_slot(add_variable(node->get_var_name()));
+}
+
+void Resolver::visit(ReturnNode * node)
+{
+    node->get_expr()->accept(this);
+
+    //the caller's frame may be reused, a top level return stops the program instead
+    node->set_tail_call(
+        within_function_ && dynamic_cast<FunctionCallNode *>(node->get_expr()) != nullptr
+    );
+}
+
+void Resolver::visit(VariableNode * node)
+{
+    if (collecting_)
+    {
+        return;
+    }
+
+    StringRef name = node->get_var_name();
+    node->set_slots(
+        find_slot(locals_, name),
+        within_function_ ? find_slot(globals_, name) : no_slot
+    );
+}
+
+void Resolver::visit(LiteralNode *)
+{
+}
+
+void Resolver::visit(UnaryMinusNode * node)
+{
+    node->get_expr()->accept(this);
+}
+
+void Resolver::visit(BinaryOperatorNode * node)
+{
+    node->get_first_expr()->accept(this);
+    node->get_second_expr()->accept(this);
+}
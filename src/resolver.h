@@ -0,0 +1,70 @@
+#include <string>
+#include <map>
+#include <vector>
+#include "pp.h"
+#include "ast.h"
+#include "ast_visitor.h"
+
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+/*
+ * Binds every variable to a fixed slot of its frame.
+ * Globals are the variables assigned at the top level, locals are the parameters
+ * followed by the variables assigned within function body.
+ * Also marks returns of a call within functions as tail calls.
+ * Must be run once after Parser::parse()
+ */
+class Resolver : public ASTNodeVisitor
+{
+    public:
+        Resolver() : arena_(nullptr), collecting_(false), within_function_(false) {}
+
+        void resolve(ProgramPtr program);
+
+        /*
+         * --stream resolves the top level as it comes: globals are collected
+         * from every statement first, then the definitions and each statement
+         * are resolved against them
+         */
+        void start(ProgramPtr program);
+        void collect_globals(ASTNodePtr statement);
+        void resolve_functions(RootNode * root);
+        void resolve_statement(ASTNodePtr statement);
+
+        virtual void visit(RootNode * node) override;
+        virtual void visit(FunctionDefinitionNode * node) override;
+        virtual void visit(AssignmentNode * node) override;
+        virtual void visit(FunctionCallNode * node) override;
+        virtual void visit(IfStatementNode * node) override;
+        virtual void visit(WhileStatementNode * node) override;
+        virtual void visit(PrintNode * node) override;
+        virtual void visit(ReadNode * node) override;
+        virtual void visit(ReturnNode * node) override;
+        virtual void visit(VariableNode * node) override;
+        virtual void visit(LiteralNode * node) override;
+        virtual void visit(UnaryMinusNode * node) override;
+        virtual void visit(BinaryOperatorNode * node) override;
+
+    private:
+        typedef std::map<std::string, int> SlotsMap;
+
+        NamesSequence resolve_frame(StatementsSequence const & statements, NamesSequence const & params);
+        void visit_sequence(StatementsSequence const & statements);
+        int add_variable(StringRef name);
+
+        static int find_slot(SlotsMap const & slots, StringRef name)
+        {
+            auto it = slots.find(name.str());
+            return it == slots.end() ? no_slot : it->second;
+        }
+
+        Arena * arena_;
+        bool collecting_;
+        bool within_function_;
+        SlotsMap globals_;
+        SlotsMap locals_;
+        std::vector<StringRef> slot_names_;
+};
+
+#endif //RESOLVER_H
@@ -0,0 +1,107 @@
+#include "spawn_pool.h"
+#include "native_stack.h"
+
+SpawnPool::SpawnPool(size_t workers, size_t stack_size, std::function<void(SpawnPool & pool, size_t queue)> const & work) :
+    queued_(0),
+    stopping_(false)
+{
+    for (size_t i = 0; i <= workers; i++)
+    {
+        queues_.emplace_back(new Queue());
+    }
+
+    for (size_t i = 1; i <= workers; i++)
+    {
+        workers_.emplace_back([this, stack_size, work, i]()
+        {
+            run_on_native_stack(stack_size, [this, &work, i]() { work(*this, i); });
+        });
+    }
+}
+
+SpawnPool::~SpawnPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        stopping_ = true;
+    }
+    idle_.notify_all();
+
+    for (std::thread & worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void SpawnPool::push(size_t queue, SpawnTask * task)
+{
+    {
+        std::lock_guard<std::mutex> lock(queues_[queue]->mutex);
+        queues_[queue]->tasks.push_back(task);
+        queued_++;
+    }
+
+    if (!workers_.empty())
+    {
+        //a worker checking for tasks holds the mutex, so it either sees the task or gets woken
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+        }
+        idle_.notify_one();
+    }
+}
+
+SpawnTask * SpawnPool::take(size_t queue, size_t min_depth)
+{
+    for (size_t i = 0; i < queues_.size(); i++)
+    {
+        bool own = i == 0;
+        Queue & victim = *queues_[(queue + i) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+
+        if (victim.tasks.empty())
+        {
+            continue;
+        }
+
+        SpawnTask * task = own ? victim.tasks.back() : victim.tasks.front();
+        if (task->depth < min_depth)
+        {
+            continue;
+        }
+
+        if (own)
+        {
+            victim.tasks.pop_back();
+        }
+        else
+        {
+            victim.tasks.pop_front();
+        }
+
+        queued_--;
+        return task;
+    }
+
+    return nullptr;
+}
+
+SpawnTask * SpawnPool::take_or_wait(size_t queue)
+{
+    while (true)
+    {
+        SpawnTask * task = take(queue, 0);
+        if (task != nullptr)
+        {
+            return task;
+        }
+
+        std::unique_lock<std::mutex> lock(idle_mutex_);
+        idle_.wait(lock, [this]() { return stopping_ || queued_ > 0; });
+
+        if (stopping_)
+        {
+            return nullptr;
+        }
+    }
+}
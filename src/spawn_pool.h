@@ -0,0 +1,90 @@
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include "pp.h"
+#include "ast.h"
+#include "value.h"
+
+#ifndef SPAWN_POOL_H
+#define SPAWN_POOL_H
+
+/*
+ * Call made by x = spawn f(...), its arguments are evaluated by the spawning
+ * function. The call node isn't kept, --stream frees it with its statement
+ */
+struct SpawnTask
+{
+    SpawnTask(FunctionDefinitionNode const * function, size_t line, size_t depth) :
+        function(function),
+        line(line),
+        depth(depth),
+        result(0),
+        done(false)
+    {}
+
+    FunctionDefinitionNode const * function;
+    size_t line;
+    std::vector<Value> args;
+    //calls being executed by the spawning function
+    size_t depth;
+    Value result;
+    std::exception_ptr error;
+    std::atomic<bool> done;
+};
+
+/*
+ * Work-stealing pool of spawned calls. Every participant has a queue of its
+ * own: queue 0 belongs to the thread which made the pool, the others to the
+ * worker threads. Participants take their latest tasks first, and steal the
+ * earliest ones of the others, which tend to be the biggest
+ */
+class SpawnPool
+{
+    public:
+        /*
+         * work runs on every worker thread with its queue until take_or_wait()
+         * returns nullptr, on a stack of stack_size bytes
+         */
+        SpawnPool(size_t workers, size_t stack_size, std::function<void(SpawnPool & pool, size_t queue)> const & work);
+        ~SpawnPool();
+
+        void push(size_t queue, SpawnTask * task);
+
+        /*
+         * a task spawned at min_depth or deeper, nullptr if there is none. Running it
+         * nested in a call at min_depth takes no more stack than calls up to max depth do
+         */
+        SpawnTask * take(size_t queue, size_t min_depth);
+
+        /*
+         * blocks until there is a task, nullptr once the pool is being destroyed
+         */
+        SpawnTask * take_or_wait(size_t queue);
+
+        SpawnPool &operator=(SpawnPool const &a) = delete;
+        SpawnPool(SpawnPool const &a) = delete;
+
+    private:
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<SpawnTask *> tasks;
+        };
+
+        std::vector<std::unique_ptr<Queue>> queues_;
+        //tasks in all queues, idle workers sleep while there are none
+        std::atomic<size_t> queued_;
+        std::mutex idle_mutex_;
+        std::condition_variable idle_;
+        bool stopping_;
+        std::vector<std::thread> workers_;
+};
+
+#endif //SPAWN_POOL_H
@@ -0,0 +1,197 @@
+#include "specializer.h"
+
+static VariableNode * as_variable(ASTNodePtr node)
+{
+    return dynamic_cast<VariableNode *>(node);
+}
+
+static LiteralNode * as_literal(ASTNodePtr node)
+{
+    return dynamic_cast<LiteralNode *>(node);
+}
+
+static bool is_comparison(ASTNodePtr node)
+{
+    BinaryOperatorNode * binary = dynamic_cast<BinaryOperatorNode *>(node);
+
+    return binary != nullptr && binary->get_type() != BinaryOperatorType::PLUS
+        && binary->get_type() != BinaryOperatorType::MINUS
+        && binary->get_type() != BinaryOperatorType::MULTIPLY
+        && binary->get_type() != BinaryOperatorType::DIVIDE;
+}
+
+size_t Specializer::specialize(ProgramPtr program)
+{
+    arena_ = &program->get_arena();
+    specialized_ = 0;
+    program->get_root()->accept(this);
+
+    return specialized_;
+}
+
+template<class T>
+void Specializer::specialize_statements(T * node)
+{
+    for (size_t i = 0; i < node->get_statements().size(); i++)
+    {
+        node->set_statement(i, specialize_node(node->get_statements()[i]));
+    }
+}
+
+/*
+ * the specialized node is made of a copy of the generic one
+ */
+template<class T, class Node>
+void Specializer::replace(Node * node)
+{
+    result_ = arena_->make<T>(*node);
+    specialized_++;
+}
+
+void Specializer::visit(RootNode * node)
+{
+    for (ASTNodePtr const & function : node->get_functions())
+    {
+        function->accept(this);
+    }
+
+    specialize_statements(node);
+}
+
+void Specializer::visit(FunctionDefinitionNode * node)
+{
+    specialize_statements(node);
+}
+
+void Specializer::visit(AssignmentNode * node)
+{
+    node->set_expr(specialize_node(node->get_expr()));
+    result_ = node;
+
+    BinaryOperatorNode * binary = dynamic_cast<BinaryOperatorNode *>(node->get_expr());
+    if (binary == nullptr || (binary->get_type() != BinaryOperatorType::PLUS && binary->get_type() != BinaryOperatorType::MINUS))
+    {
+        return;
+    }
+
+    VariableNode * variable = as_variable(binary->get_first_expr());
+    LiteralNode * literal = as_literal(binary->get_second_expr());
+
+    if (variable == nullptr && binary->get_type() == BinaryOperatorType::PLUS)
+    {
+        //literal + x
+        variable = as_variable(binary->get_second_expr());
+        literal = as_literal(binary->get_first_expr());
+    }
+
+    //the variable is read where it's assigned, from the same frame
+    if (variable == nullptr || literal == nullptr || variable->get_var_name() != node->get_var_name()
+        || variable->get_slot() != node->get_slot())
+    {
+        return;
+    }
+
+    pp_value_t delta = literal->get_value();
+    if (binary->get_type() == BinaryOperatorType::MINUS)
+    {
+        //the delta of x - minimum doesn't fit
+        if (delta == INT64_MIN)
+        {
+            return;
+        }
+
+        delta = -delta;
+    }
+
+    result_ = arena_->make<IncrementNode>(*node, variable, delta);
+    specialized_++;
+}
+
+void Specializer::visit(FunctionCallNode * node)
+{
+    for (size_t i = 0; i < node->get_params().size(); i++)
+    {
+        node->set_param(i, specialize_node(node->get_params()[i]));
+    }
+
+    result_ = node;
+}
+
+void Specializer::visit(IfStatementNode * node)
+{
+    node->set_expr(specialize_node(node->get_expr()));
+    specialize_statements(node);
+    result_ = node;
+
+    if (is_comparison(node->get_expr()))
+    {
+        replace<CompareIfNode>(node);
+    }
+}
+
+void Specializer::visit(WhileStatementNode * node)
+{
+    node->set_expr(specialize_node(node->get_expr()));
+    specialize_statements(node);
+    result_ = node;
+
+    if (is_comparison(node->get_expr()))
+    {
+        replace<CompareWhileNode>(node);
+    }
+}
+
+void Specializer::visit(PrintNode * node)
+{
+    node->set_expr(specialize_node(node->get_expr()));
+    result_ = node;
+}
+
+void Specializer::visit(ReadNode * node)
+{
+    result_ = node;
+}
+
+void Specializer::visit(ReturnNode * node)
+{
+    //a tail call keeps its node, only the arguments are specialized
+    node->set_expr(specialize_node(node->get_expr()));
+    result_ = node;
+}
+
+void Specializer::visit(VariableNode * node)
+{
+    result_ = node;
+}
+
+void Specializer::visit(LiteralNode * node)
+{
+    result_ = node;
+}
+
+void Specializer::visit(UnaryMinusNode * node)
+{
+    node->set_expr(specialize_node(node->get_expr()));
+    result_ = node;
+}
+
+void Specializer::visit(BinaryOperatorNode * node)
+{
+    node->set_first_expr(specialize_node(node->get_first_expr()));
+    node->set_second_expr(specialize_node(node->get_second_expr()));
+    result_ = node;
+
+    if (as_variable(node->get_first_expr()) == nullptr)
+    {
+        return;
+    }
+
+    if (as_literal(node->get_second_expr()) != nullptr)
+    {
+        replace<VariableLiteralOperatorNode>(node);
+    }
+    else if (as_variable(node->get_second_expr()) != nullptr)
+    {
+        replace<VariablesOperatorNode>(node);
+    }
+}
@@ -0,0 +1,69 @@
+#include "pp.h"
+#include "ast.h"
+#include "ast_visitor.h"
+
+#ifndef SPECIALIZER_H
+#define SPECIALIZER_H
+
+/*
+ * Replaces frequent shapes of the resolved program with specialized node kinds
+ * Interpreter has fast paths for: x op literal, x op y, if and while on
+ * a comparison, and x = x + literal or x = x - literal
+ */
+class Specializer : public ASTNodeVisitor
+{
+    public:
+        Specializer() : arena_(nullptr), result_(nullptr), specialized_(0) {}
+
+        /*
+         * returns the number of nodes replaced
+         */
+        size_t specialize(ProgramPtr program);
+
+        /*
+         * returns the node a top-level statement of --stream should be replaced with,
+         * built in the arena given
+         */
+        ASTNodePtr specialize_statement(ASTNodePtr statement, Arena & arena)
+        {
+            arena_ = &arena;
+            return specialize_node(statement);
+        }
+
+        virtual void visit(RootNode * node) override;
+        virtual void visit(FunctionDefinitionNode * node) override;
+        virtual void visit(AssignmentNode * node) override;
+        virtual void visit(FunctionCallNode * node) override;
+        virtual void visit(IfStatementNode * node) override;
+        virtual void visit(WhileStatementNode * node) override;
+        virtual void visit(PrintNode * node) override;
+        virtual void visit(ReadNode * node) override;
+        virtual void visit(ReturnNode * node) override;
+        virtual void visit(VariableNode * node) override;
+        virtual void visit(LiteralNode * node) override;
+        virtual void visit(UnaryMinusNode * node) override;
+        virtual void visit(BinaryOperatorNode * node) override;
+
+    private:
+        /*
+         * returns the node should be replaced with
+         */
+        ASTNodePtr specialize_node(ASTNodePtr node)
+        {
+            result_ = node;
+            node->accept(this);
+            return result_;
+        }
+
+        template<class T>
+        void specialize_statements(T * node);
+
+        template<class T, class Node>
+        void replace(Node * node);
+
+        Arena * arena_;
+        ASTNodePtr result_;
+        size_t specialized_;
+};
+
+#endif //SPECIALIZER_H
@@ -0,0 +1,252 @@
+#include <chrono>
+#include <iomanip>
+#include "stats.h"
+
+static char const * const node_kind_names[] = {
+    "root", "function definition", "assignment", "function call",
+    "if", "while", "print", "read", "return",
+    "variable", "literal", "unary minus", "binary operator"
+};
+
+void NodeCounts::report(std::ostream & os, std::string const & title) const
+{
+    os << "  " << title << ":" << std::endl;
+
+    for (size_t i = 0; i < static_cast<size_t>(NodeKind::KINDS_NUM); i++)
+    {
+        if (counts_[i] > 0)
+        {
+            os << "    " << std::left << std::setw(22) << node_kind_names[i]
+               << std::right << std::setw(14) << counts_[i] << std::endl;
+        }
+    }
+}
+
+void NodeCounter::visit_sequence(StatementsSequence const & statements)
+{
+    for (ASTNodePtr const & statement : statements)
+    {
+        statement->accept(this);
+    }
+}
+
+void NodeCounter::visit(RootNode * node)
+{
+    counts_.add(NodeKind::ROOT);
+    visit_sequence(node->get_functions());
+    visit_sequence(node->get_statements());
+}
+
+void NodeCounter::visit(FunctionDefinitionNode * node)
+{
+    counts_.add(NodeKind::FUNCTION_DEFINITION);
+    visit_sequence(node->get_statements());
+}
+
+void NodeCounter::visit(AssignmentNode * node)
+{
+    counts_.add(NodeKind::ASSIGNMENT);
+    node->get_expr()->accept(this);
+}
+
+void NodeCounter::visit(FunctionCallNode * node)
+{
+    counts_.add(NodeKind::FUNCTION_CALL);
+    visit_sequence(node->get_params());
+}
+
+void NodeCounter::visit(IfStatementNode * node)
+{
+    counts_.add(NodeKind::IF_STATEMENT);
+    node->get_expr()->accept(this);
+    visit_sequence(node->get_statements());
+}
+
+void NodeCounter::visit(WhileStatementNode * node)
+{
+    counts_.add(NodeKind::WHILE_STATEMENT);
+    node->get_expr()->accept(this);
+    visit_sequence(node->get_statements());
+}
+
+void NodeCounter::visit(PrintNode * node)
+{
+    counts_.add(NodeKind::PRINT);
+    node->get_expr()->accept(this);
+}
+
+void NodeCounter::visit(ReadNode *)
+{
+    counts_.add(NodeKind::READ);
+}
+
+void NodeCounter::visit(ReturnNode * node)
+{
+    counts_.add(NodeKind::RETURN);
+    node->get_expr()->accept(this);
+}
+
+void NodeCounter::visit(VariableNode *)
+{
+    counts_.add(NodeKind::VARIABLE);
+}
+
+void NodeCounter::visit(LiteralNode *)
+{
+    counts_.add(NodeKind::LITERAL);
+}
+
+void NodeCounter::visit(UnaryMinusNode * node)
+{
+    counts_.add(NodeKind::UNARY_MINUS);
+    node->get_expr()->accept(this);
+}
+
+void NodeCounter::visit(BinaryOperatorNode * node)
+{
+    counts_.add(NodeKind::BINARY_OPERATOR);
+    node->get_first_expr()->accept(this);
+    node->get_second_expr()->accept(this);
+}
+
+void StatsInterpreter::visit(RootNode * node)
+{
+    count(NodeKind::ROOT);
+    Interpreter::visit(node);
+}
+
+void StatsInterpreter::visit(FunctionDefinitionNode * node)
+{
+    count(NodeKind::FUNCTION_DEFINITION);
+    Interpreter::visit(node);
+}
+
+void StatsInterpreter::visit(AssignmentNode * node)
+{
+    count(NodeKind::ASSIGNMENT);
+    Interpreter::visit(node);
+}
+
+void StatsInterpreter::visit(FunctionCallNode * node)
+{
+    count(NodeKind::FUNCTION_CALL);
+    calls_++;
+    Interpreter::visit(node);
+}
+
+void StatsInterpreter::visit(IfStatementNode * node)
+{
+    count(NodeKind::IF_STATEMENT);
+    Interpreter::visit(node);
+}
+
+void StatsInterpreter::visit(WhileStatementNode * node)
+{
+    count(NodeKind::WHILE_STATEMENT);
+    Interpreter::visit(node);
+}
+
+void StatsInterpreter::visit(PrintNode * node)
+{
+    count(NodeKind::PRINT);
+    Interpreter::visit(node);
+}
+
+void StatsInterpreter::visit(ReadNode * node)
+{
+    count(NodeKind::READ);
+    Interpreter::visit(node);
+}
+
+void StatsInterpreter::visit(ReturnNode * node)
+{
+    count(NodeKind::RETURN);
+
+    //a tail call is made by the caller's loop, it never visits the call node
+    if (is_tail_call(node))
+    {
+        count(NodeKind::FUNCTION_CALL);
+        calls_++;
+    }
+
+    Interpreter::visit(node);
+}
+
+void StatsInterpreter::visit(VariableNode * node)
+{
+    count(NodeKind::VARIABLE);
+
+    if (is_local_read(node))
+    {
+        local_reads_++;
+    }
+    else
+    {
+        global_reads_++;
+    }
+
+    Interpreter::visit(node);
+}
+
+void StatsInterpreter::visit(LiteralNode * node)
+{
+    count(NodeKind::LITERAL);
+    Interpreter::visit(node);
+}
+
+void StatsInterpreter::visit(UnaryMinusNode * node)
+{
+    count(NodeKind::UNARY_MINUS);
+    Interpreter::visit(node);
+}
+
+void StatsInterpreter::visit(BinaryOperatorNode * node)
+{
+    count(NodeKind::BINARY_OPERATOR);
+    Interpreter::visit(node);
+}
+
+void StatsInterpreter::report(std::ostream & os) const
+{
+    visits_.report(os, "node visits");
+    os << "  function calls: " << calls_ << ", max call depth: " << max_depth_ << std::endl;
+
+    //a variable is looked up in the current frame first, then one level up in globals
+    os << "  variable lookups: " << local_reads_ + global_reads_
+       << " (" << local_reads_ << " in current frame, "
+       << global_reads_ << " walked up to globals)" << std::endl;
+}
+
+double Stats::lex(IScanner & scanner)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    try
+    {
+        while (scanner.next_lexeme() != LexemeType::EOFL)
+        {
+            tokens_++;
+        }
+    }
+    catch (LineNumberException &)
+    {
+        //the error is reported by the parser
+    }
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Stats::report(std::ostream & os) const
+{
+    os << "stats:" << std::endl;
+
+    for (auto const & phase : phases_)
+    {
+        os << "  " << std::left << std::setw(24) << phase.first + " time:"
+           << std::right << std::setw(12) << std::fixed << std::setprecision(3)
+           << phase.second * 1000 << " ms" << std::endl;
+    }
+
+    os << "  tokens: " << tokens_ << std::endl;
+    nodes_.report(os, "AST nodes");
+}
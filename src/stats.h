@@ -0,0 +1,160 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <utility>
+#include "pp.h"
+#include "ast.h"
+#include "ast_visitor.h"
+#include "parser.h"
+#include "interpreter.h"
+
+#ifndef STATS_H
+#define STATS_H
+
+enum class NodeKind : short int
+{
+    ROOT, FUNCTION_DEFINITION, ASSIGNMENT, FUNCTION_CALL,
+    IF_STATEMENT, WHILE_STATEMENT, PRINT, READ, RETURN,
+    VARIABLE, LITERAL, UNARY_MINUS, BINARY_OPERATOR,
+    KINDS_NUM
+};
+
+/*
+ * Counter per node type
+ */
+class NodeCounts
+{
+    public:
+        NodeCounts() : counts_() {}
+
+        void add(NodeKind kind) { counts_[static_cast<size_t>(kind)]++; }
+
+        void report(std::ostream & os, std::string const & title) const;
+
+    private:
+        size_t counts_[static_cast<size_t>(NodeKind::KINDS_NUM)];
+};
+
+/*
+ * Counts the nodes of the tree by type
+ */
+class NodeCounter : public ASTNodeVisitor
+{
+    public:
+        NodeCounts const & count(ASTNodePtr root)
+        {
+            root->accept(this);
+            return counts_;
+        }
+
+        virtual void visit(RootNode * node) override;
+        virtual void visit(FunctionDefinitionNode * node) override;
+        virtual void visit(AssignmentNode * node) override;
+        virtual void visit(FunctionCallNode * node) override;
+        virtual void visit(IfStatementNode * node) override;
+        virtual void visit(WhileStatementNode * node) override;
+        virtual void visit(PrintNode * node) override;
+        virtual void visit(ReadNode * node) override;
+        virtual void visit(ReturnNode * node) override;
+        virtual void visit(VariableNode * node) override;
+        virtual void visit(LiteralNode * node) override;
+        virtual void visit(UnaryMinusNode * node) override;
+        virtual void visit(BinaryOperatorNode * node) override;
+
+    private:
+        void visit_sequence(StatementsSequence const & statements);
+
+        NodeCounts counts_;
+};
+
+/*
+ * Interpreter counting what it does. Only --stats creates it,
+ * so the plain Interpreter pays nothing for the counters
+ */
+class StatsInterpreter : public Interpreter
+{
+    public:
+        StatsInterpreter(OutputBuffer & output, InputReader & input) :
+            Interpreter(output, input),
+            calls_(0),
+            max_depth_(0),
+            local_reads_(0),
+            global_reads_(0)
+        {}
+
+        void report(std::ostream & os) const;
+
+        virtual void visit(RootNode * node) override;
+        virtual void visit(FunctionDefinitionNode * node) override;
+        virtual void visit(AssignmentNode * node) override;
+        virtual void visit(FunctionCallNode * node) override;
+        virtual void visit(IfStatementNode * node) override;
+        virtual void visit(WhileStatementNode * node) override;
+        virtual void visit(PrintNode * node) override;
+        virtual void visit(ReadNode * node) override;
+        virtual void visit(ReturnNode * node) override;
+        virtual void visit(VariableNode * node) override;
+        virtual void visit(LiteralNode * node) override;
+        virtual void visit(UnaryMinusNode * node) override;
+        virtual void visit(BinaryOperatorNode * node) override;
+
+        //specialized kinds are counted as the generic nodes
+        virtual void visit(VariableLiteralOperatorNode * node) override { visit(static_cast<BinaryOperatorNode *>(node)); }
+        virtual void visit(VariablesOperatorNode * node) override { visit(static_cast<BinaryOperatorNode *>(node)); }
+        virtual void visit(CompareIfNode * node) override { visit(static_cast<IfStatementNode *>(node)); }
+        virtual void visit(CompareWhileNode * node) override { visit(static_cast<WhileStatementNode *>(node)); }
+        virtual void visit(IncrementNode * node) override { visit(static_cast<AssignmentNode *>(node)); }
+
+    private:
+        /*
+         * every statement of a function body is visited within its frame,
+         * that's where the depth is sampled
+         */
+        void count(NodeKind kind)
+        {
+            visits_.add(kind);
+            if (get_depth() > max_depth_)
+            {
+                max_depth_ = get_depth();
+            }
+        }
+
+        NodeCounts visits_;
+        size_t calls_;
+        size_t max_depth_;
+        size_t local_reads_;
+        size_t global_reads_;
+};
+
+/*
+ * Wall time of the pipeline phases and the totals collected by --stats
+ */
+class Stats
+{
+    public:
+        Stats() : tokens_(0) {}
+
+        void add_phase(std::string const & name, double seconds)
+        {
+            phases_.push_back(std::make_pair(name, seconds));
+        }
+
+        /*
+         * lexes the whole input on its own, returns the time it took
+         */
+        double lex(IScanner & scanner);
+
+        void count_nodes(ASTNodePtr root)
+        {
+            nodes_ = NodeCounter().count(root);
+        }
+
+        void report(std::ostream & os) const;
+
+    private:
+        std::vector<std::pair<std::string, double>> phases_;
+        size_t tokens_;
+        NodeCounts nodes_;
+};
+
+#endif //STATS_H
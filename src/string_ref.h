@@ -0,0 +1,57 @@
+#include <string>
+#include <cstring>
+
+#ifndef STRING_REF_H
+#define STRING_REF_H
+
+/*
+ * Non-owning view of a characters range, the storage must outlive it
+ */
+class StringRef
+{
+    public:
+        StringRef() : data_(nullptr), size_(0) {}
+        StringRef(char const * data, size_t size) : data_(data), size_(size) {}
+
+        char const * data() const { return data_; }
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        char operator[](size_t i) const { return data_[i]; }
+
+        std::string str() const { return std::string(data_, size_); }
+
+        bool operator==(StringRef const & other) const
+        {
+            return size_ == other.size_ && std::memcmp(data_, other.data_, size_) == 0;
+        }
+
+        bool operator!=(StringRef const & other) const { return !(*this == other); }
+
+    private:
+        char const * data_;
+        size_t size_;
+};
+
+inline std::string operator+(std::string const & a, StringRef b)
+{
+    return a + b.str();
+}
+
+/*
+ * FNV-1a hash to key unordered containers by StringRef
+ */
+struct StringRefHash
+{
+    size_t operator()(StringRef const & ref) const
+    {
+        size_t hash = 2166136261u;
+        for (size_t i = 0; i < ref.size(); i++)
+        {
+            hash = (hash ^ static_cast<unsigned char>(ref[i])) * 16777619u;
+        }
+
+        return hash;
+    }
+};
+
+#endif //STRING_REF_H
@@ -0,0 +1,77 @@
+#include "value.h"
+
+Value Value::of(BigInt && number)
+{
+    pp_value_t small;
+    if (number.to_small(small))
+    {
+        return small;
+    }
+
+    Value value;
+    value.big_ = new Big(std::move(number));
+
+    return value;
+}
+
+std::string Value::to_string() const
+{
+    return big_ == nullptr ? std::to_string(small_) : big_->number.to_decimal();
+}
+
+Value Value::add_big(Value const & a, Value const & b)
+{
+    return of(a.to_big() + b.to_big());
+}
+
+Value Value::subtract_big(Value const & a, Value const & b)
+{
+    return of(a.to_big() - b.to_big());
+}
+
+Value Value::multiply_big(Value const & a, Value const & b)
+{
+    return of(a.to_big() * b.to_big());
+}
+
+Value Value::divide_big(Value const & a, Value const & b)
+{
+    return of(a.to_big() / b.to_big());
+}
+
+Value Value::negate_big(Value const & a)
+{
+    return of(-a.to_big());
+}
+
+int Value::compare_big(Value const & a, Value const & b)
+{
+    //big ones don't fit, so they are beyond every small one
+    if (a.big_ == nullptr)
+    {
+        return b.big_->number.is_negative() ? 1 : -1;
+    }
+
+    if (b.big_ == nullptr)
+    {
+        return a.big_->number.is_negative() ? -1 : 1;
+    }
+
+    return a.big_->number.compare(b.big_->number);
+}
+
+Value & Value::assign(Value && a) noexcept
+{
+    std::swap(small_, a.small_);
+    std::swap(big_, a.big_);
+
+    return *this;
+}
+
+void Value::release()
+{
+    if (--big_->refs == 0)
+    {
+        delete big_;
+    }
+}
@@ -0,0 +1,198 @@
+#include <cstdint>
+#include <atomic>
+#include <string>
+#include <utility>
+#include "pp.h"
+#include "bigint.h"
+
+#ifndef VALUE_H
+#define VALUE_H
+
+/*
+ * Integer value of a program. It's an unboxed pp_value_t while it fits,
+ * arithmetic checks for overflow and promotes the result to a BigInt shared
+ * by reference counting. Results that fit again are unboxed, so a value is
+ * small exactly when it fits, and comparing the small parts is enough
+ */
+class Value
+{
+    public:
+        Value() : small_(0), big_(nullptr) {}
+        Value(pp_value_t small) : small_(small), big_(nullptr) {}
+
+        Value(Value const & a) :
+            small_(a.small_),
+            big_(a.big_)
+        {
+            if (big_ != nullptr)
+            {
+                big_->refs++;
+            }
+        }
+
+        Value(Value && a) noexcept :
+            small_(a.small_),
+            big_(a.big_)
+        {
+            a.big_ = nullptr;
+        }
+
+        ~Value()
+        {
+            if (big_ != nullptr)
+            {
+                release();
+            }
+        }
+
+        Value & operator=(Value const & a)
+        {
+            if (big_ == nullptr && a.big_ == nullptr)
+            {
+                small_ = a.small_;
+                return *this;
+            }
+
+            return assign(Value(a));
+        }
+
+        Value & operator=(Value && a) noexcept
+        {
+            if (big_ == nullptr && a.big_ == nullptr)
+            {
+                small_ = a.small_;
+                return *this;
+            }
+
+            return assign(std::move(a));
+        }
+
+        /*
+         * unboxed if the number fits
+         */
+        static Value of(BigInt && number);
+
+        bool is_small() const { return big_ == nullptr; }
+        pp_value_t get_small() const { return small_; }
+        bool is_zero() const { return big_ == nullptr && small_ == 0; }
+
+        BigInt to_big() const { return big_ == nullptr ? BigInt(small_) : big_->number; }
+        std::string to_string() const;
+        uint64_t hash() const { return big_ == nullptr ? static_cast<uint64_t>(small_) : big_->number.hash(); }
+
+        friend Value operator+(Value const & a, Value const & b)
+        {
+            pp_value_t result;
+            if (a.big_ == nullptr && b.big_ == nullptr && !__builtin_add_overflow(a.small_, b.small_, &result))
+            {
+                return result;
+            }
+
+            return add_big(a, b);
+        }
+
+        friend Value operator-(Value const & a, Value const & b)
+        {
+            pp_value_t result;
+            if (a.big_ == nullptr && b.big_ == nullptr && !__builtin_sub_overflow(a.small_, b.small_, &result))
+            {
+                return result;
+            }
+
+            return subtract_big(a, b);
+        }
+
+        friend Value operator*(Value const & a, Value const & b)
+        {
+            pp_value_t result;
+            if (a.big_ == nullptr && b.big_ == nullptr && !__builtin_mul_overflow(a.small_, b.small_, &result))
+            {
+                return result;
+            }
+
+            return multiply_big(a, b);
+        }
+
+        /*
+         * truncates toward zero, b mustn't be zero
+         */
+        friend Value operator/(Value const & a, Value const & b)
+        {
+            if (a.big_ == nullptr && b.big_ == nullptr)
+            {
+                //dividing 32-bit operands is several times faster, they are the usual ones
+                if ((static_cast<uint64_t>(a.small_) | static_cast<uint64_t>(b.small_)) >> 32 == 0)
+                {
+                    return static_cast<uint32_t>(a.small_) / static_cast<uint32_t>(b.small_);
+                }
+
+                if (!(a.small_ == INT64_MIN && b.small_ == -1))
+                {
+                    return a.small_ / b.small_;
+                }
+            }
+
+            return divide_big(a, b);
+        }
+
+        Value operator-() const
+        {
+            if (big_ == nullptr && small_ != INT64_MIN)
+            {
+                return -small_;
+            }
+
+            return negate_big(*this);
+        }
+
+        friend bool operator==(Value const & a, Value const & b)
+        {
+            if (a.big_ == nullptr || b.big_ == nullptr)
+            {
+                return a.big_ == b.big_ && a.small_ == b.small_;
+            }
+
+            return a.big_->number.compare(b.big_->number) == 0;
+        }
+
+        friend bool operator!=(Value const & a, Value const & b) { return !(a == b); }
+        friend bool operator<(Value const & a, Value const & b) { return compare(a, b) < 0; }
+        friend bool operator<=(Value const & a, Value const & b) { return compare(a, b) <= 0; }
+        friend bool operator>(Value const & a, Value const & b) { return compare(a, b) > 0; }
+        friend bool operator>=(Value const & a, Value const & b) { return compare(a, b) >= 0; }
+
+    private:
+        struct Big
+        {
+            Big(BigInt && number) : refs(1), number(std::move(number)) {}
+
+            //values are shared by the threads running spawned calls
+            std::atomic<size_t> refs;
+            BigInt number;
+        };
+
+        static int compare(Value const & a, Value const & b)
+        {
+            if (a.big_ == nullptr && b.big_ == nullptr)
+            {
+                return a.small_ < b.small_ ? -1 : a.small_ > b.small_;
+            }
+
+            return compare_big(a, b);
+        }
+
+        //out of line, so the small paths stay short where they are inlined
+        static Value add_big(Value const & a, Value const & b);
+        static Value subtract_big(Value const & a, Value const & b);
+        static Value multiply_big(Value const & a, Value const & b);
+        static Value divide_big(Value const & a, Value const & b);
+        static Value negate_big(Value const & a);
+        static int compare_big(Value const & a, Value const & b);
+        Value & assign(Value && a) noexcept;
+        void release();
+
+        pp_value_t small_;
+        Big * big_;
+};
+
+#endif //VALUE_H
@@ -0,0 +1,219 @@
+#include <cstring>
+#include <algorithm>
+#include "vm.h"
+
+void VM::execute()
+{
+    Frame frame{&program_.main, 0, 0, 0};
+
+    ensure_registers(frame.function->frame_size);
+
+    const Instruction * code = frame.function->code.data();
+    Value * regs = registers_.data();
+    unsigned char * defined = defined_.data();
+    size_t pc = 0;
+
+    while (true)
+    {
+        Instruction const & ins = code[pc++];
+
+        switch (ins.op)
+        {
+            case OpCode::LOADK:
+                regs[ins.a] = ins.b;
+                break;
+            case OpCode::LOADC:
+                regs[ins.a] = program_.constants[ins.b];
+                break;
+            case OpCode::MOVE:
+                regs[ins.a] = regs[ins.b];
+                break;
+            case OpCode::GETVAR:
+                if (defined[ins.b])
+                {
+                    regs[ins.a] = regs[ins.b];
+                }
+                else if (ins.c >= 0 && defined_[ins.c])
+                {
+                    regs[ins.a] = registers_[ins.c];
+                }
+                else
+                {
+                    throw_error("undefined variable " + frame.function->slot_names[ins.b], frame, pc - 1);
+                }
+                break;
+            case OpCode::GETGLOBAL:
+                if (!defined_[ins.b])
+                {
+                    throw_error("undefined variable " + program_.main.slot_names[ins.b], frame, pc - 1);
+                }
+                regs[ins.a] = registers_[ins.b];
+                break;
+            case OpCode::DEFINE:
+                defined[ins.a] = 1;
+                break;
+            case OpCode::NEG:
+                regs[ins.a] = -regs[ins.b];
+                break;
+            case OpCode::ADD:
+                regs[ins.a] = regs[ins.b] + regs[ins.c];
+                break;
+            case OpCode::SUB:
+                regs[ins.a] = regs[ins.b] - regs[ins.c];
+                break;
+            case OpCode::MUL:
+                regs[ins.a] = regs[ins.b] * regs[ins.c];
+                break;
+            case OpCode::DIV:
+                if (regs[ins.c].is_zero())
+                {
+                    throw_error("division by zero", frame, pc - 1);
+                }
+                regs[ins.a] = regs[ins.b] / regs[ins.c];
+                break;
+            case OpCode::EQ:
+                regs[ins.a] = regs[ins.b] == regs[ins.c];
+                break;
+            case OpCode::NE:
+                regs[ins.a] = regs[ins.b] != regs[ins.c];
+                break;
+            case OpCode::LT:
+                regs[ins.a] = regs[ins.b] < regs[ins.c];
+                break;
+            case OpCode::LE:
+                regs[ins.a] = regs[ins.b] <= regs[ins.c];
+                break;
+            case OpCode::GT:
+                regs[ins.a] = regs[ins.b] > regs[ins.c];
+                break;
+            case OpCode::GE:
+                regs[ins.a] = regs[ins.b] >= regs[ins.c];
+                break;
+            case OpCode::ADDK:
+                regs[ins.a] = regs[ins.b] + ins.c;
+                break;
+            case OpCode::JMP:
+                pc = ins.a;
+                break;
+            case OpCode::JMPIFNOT:
+                if (regs[ins.a] <= 0)
+                {
+                    pc = ins.b;
+                }
+                break;
+            case OpCode::JEQ:
+                if (!(regs[ins.a] == regs[ins.b]))
+                {
+                    pc = ins.c;
+                }
+                break;
+            case OpCode::JNE:
+                if (!(regs[ins.a] != regs[ins.b]))
+                {
+                    pc = ins.c;
+                }
+                break;
+            case OpCode::JLT:
+                if (!(regs[ins.a] < regs[ins.b]))
+                {
+                    pc = ins.c;
+                }
+                break;
+            case OpCode::JLE:
+                if (!(regs[ins.a] <= regs[ins.b]))
+                {
+                    pc = ins.c;
+                }
+                break;
+            case OpCode::JGT:
+                if (!(regs[ins.a] > regs[ins.b]))
+                {
+                    pc = ins.c;
+                }
+                break;
+            case OpCode::JGE:
+                if (!(regs[ins.a] >= regs[ins.b]))
+                {
+                    pc = ins.c;
+                }
+                break;
+            case OpCode::CALL:
+            {
+                FunctionCode const & callee = program_.functions[ins.b];
+                size_t base = frame.base + ins.c;
+
+                if (frames_.size() >= max_depth_)
+                {
+                    throw_error("maximum call depth exceeded", frame, pc - 1);
+                }
+
+                frame.pc = pc;
+                frames_.push_back(frame);
+
+                ensure_registers(base + callee.frame_size);
+                std::memset(&defined_[base], 1, callee.params_num);
+                std::memset(&defined_[base + callee.params_num], 0, callee.variables_num - callee.params_num);
+
+                frame = Frame{&callee, 0, base, ins.a};
+                code = callee.code.data();
+                regs = &registers_[base];
+                defined = &defined_[base];
+                pc = 0;
+                break;
+            }
+            case OpCode::TAILCALL:
+            {
+                FunctionCode const & callee = program_.functions[ins.b];
+                size_t args = frame.base + ins.c;
+
+                ensure_registers(frame.base + callee.frame_size);
+                regs = &registers_[frame.base];
+                defined = &defined_[frame.base];
+
+                std::move(&registers_[args], &registers_[args] + callee.params_num, regs);
+                std::memset(defined, 1, callee.params_num);
+                std::memset(defined + callee.params_num, 0, callee.variables_num - callee.params_num);
+
+                frame.function = &callee;
+                code = callee.code.data();
+                pc = 0;
+                break;
+            }
+            case OpCode::RET:
+            case OpCode::RET0:
+            {
+                Value value = ins.op == OpCode::RET ? std::move(regs[ins.a]) : Value(0);
+                int32_t result = frame.result;
+
+                frame = frames_.back();
+                frames_.pop_back();
+
+                code = frame.function->code.data();
+                regs = &registers_[frame.base];
+                defined = &defined_[frame.base];
+                pc = frame.pc;
+
+                regs[result] = std::move(value);
+                break;
+            }
+            case OpCode::HALT:
+                frames_.clear();
+                return;
+            case OpCode::PRINT:
+                output_.print(regs[ins.a]);
+                break;
+            case OpCode::READ:
+            {
+                ReadResult result = input_.read(regs[ins.a]);
+                if (result != ReadResult::OK)
+                {
+                    throw_error(InputReader::error_message(result), frame, pc - 1);
+                }
+                break;
+            }
+            case OpCode::FAIL:
+                throw_error(program_.messages[ins.a], frame, pc - 1);
+                break;
+        }
+    }
+}
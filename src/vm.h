@@ -0,0 +1,75 @@
+#include <string>
+#include <vector>
+#include "pp.h"
+#include "value.h"
+#include "bytecode.h"
+#include "output.h"
+#include "input.h"
+
+#ifndef VM_H
+#define VM_H
+
+class VMRuntimeException : public LineNumberException
+{
+    public:
+        VMRuntimeException(size_t line, std::string const & msg) :
+            LineNumberException(line, msg)
+        {}
+};
+
+class VM
+{
+    public:
+        static const size_t default_max_depth = 1000000;
+
+        VM(BytecodeProgram const & program, OutputBuffer & output, InputReader & input) :
+            program_(program),
+            output_(output),
+            input_(input),
+            max_depth_(default_max_depth)
+        {}
+
+        /*
+         * deeper calls fail with a runtime error
+         */
+        void set_max_depth(size_t max_depth) { max_depth_ = max_depth; }
+
+        void execute();
+
+        VM &operator=(VM const &a) = delete;
+        VM(VM const &a) = delete;
+
+    private:
+        struct Frame
+        {
+            FunctionCode const * function;
+            size_t pc;
+            size_t base;
+            int32_t result;
+        };
+
+        void throw_error(std::string const & msg, Frame const & frame, size_t pc) const
+        {
+            throw VMRuntimeException(frame.function->lines[pc], msg);
+        }
+
+        void ensure_registers(size_t size)
+        {
+            if (registers_.size() < size)
+            {
+                registers_.resize(size * 2);
+                defined_.resize(size * 2);
+            }
+        }
+
+        BytecodeProgram const & program_;
+        OutputBuffer & output_;
+        InputReader & input_;
+        size_t max_depth_;
+
+        std::vector<Value> registers_;
+        std::vector<unsigned char> defined_;
+        std::vector<Frame> frames_;
+};
+
+#endif //VM_H